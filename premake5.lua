@@ -9,10 +9,18 @@ project "zen-app"
 
 	files { "src/**.hpp", "src/**.cpp" }
 
-	buildoptions { "-mavx2" }
+	-- keep rounding identical between the scalar and every SIMD kernel
+	buildoptions { "-ffp-contract=off" }
 	linkoptions ("`sdl2-config --libs`")
 	links { "fmt", "gmp", "gmpxx" }
 
+	-- the kernels are built once per instruction set and selected at runtime (see Zen/Kernels.hpp)
+	filter { "files:src/Zen/Kernels/Avx2.cpp" }
+		buildoptions { "-mavx2", "-mfma" }
+
+	filter { "files:src/Zen/Kernels/Avx512.cpp" }
+		buildoptions { "-mavx512f", "-mavx512dq", "-mfma" }
+
 	filter { "configurations:debug" }
 		symbols "On"
 		defines { "DEBUG" }
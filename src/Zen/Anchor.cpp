@@ -0,0 +1,84 @@
+#include "Anchor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "Hash.hpp"
+
+namespace Zen
+{
+
+auto BitsForZoom(const double zoom) -> mp_bitcnt_t
+{
+	return (mp_bitcnt_t)std::max(64.0, std::log2(zoom) + 64.0);
+}
+
+/**
+ * @brief Round to double-double, get_d truncates, so both parts go through the normalizing sum
+ */
+static auto ToDoubleDouble(const mpf_class &value) -> DoubleDouble
+{
+	const auto hi = value.get_d();
+	const mpf_class rest(value - hi, value.get_prec());
+	return DoubleDouble(hi) + DoubleDouble(rest.get_d());
+}
+
+/**
+ * @brief Hash the digits, unlike the limbs they don't depend on the precision the value is kept in
+ */
+static auto HashMpf(const size_t hash, const mpf_class &value) -> size_t
+{
+	mp_exp_t exponent;
+	const auto digits = value.get_str(exponent, 16);
+	return HashValue(HashBytes(hash, digits.data(), digits.size()), (int64_t)exponent);
+}
+
+Anchor::Anchor()
+	: Anchor(mpf_class(0), mpf_class(0))
+{
+}
+
+Anchor::Anchor(const mpf_class &real, const mpf_class &imag)
+	: real(real)
+	, imag(imag)
+	, realDoubleDouble(ToDoubleDouble(real))
+	, imagDoubleDouble(ToDoubleDouble(imag))
+	, hash(HashMpf(HashMpf(HashSeed, real), imag))
+{
+}
+
+auto Anchor::Moved(const Vec2l &pixels, const double zoom) const -> Anchor
+{
+	const auto bits = BitsForZoom(zoom);
+	const mpf_class zoomMpf(zoom, bits);
+
+	return {
+		mpf_class(real + mpf_class((long)pixels.x, bits) / zoomMpf, bits),
+		mpf_class(imag + mpf_class((long)pixels.y, bits) / zoomMpf, bits)
+	};
+}
+
+auto Anchor::PixelsFrom(const Anchor &other, const double zoom, Vec2l &pixels) const -> bool
+{
+	// the difference is exact, the whole pixels of it have to survive the multiplication
+	const auto bits = std::max({ real.get_prec(), imag.get_prec(), other.real.get_prec(), other.imag.get_prec() }) + 64;
+	const mpf_class zoomMpf(zoom, bits);
+
+	const mpf_class x(floor(mpf_class((real - other.real) * zoomMpf, bits) + 0.5), bits);
+	const mpf_class y(floor(mpf_class((imag - other.imag) * zoomMpf, bits) + 0.5), bits);
+	if (!x.fits_slong_p() || !y.fits_slong_p())
+	{
+		return false;
+	}
+
+	pixels = { x.get_si(), y.get_si() };
+	return true;
+}
+
+auto Anchor::operator==(const Anchor &other) const -> bool
+{
+	return hash == other.hash && cmp(real, other.real) == 0 && cmp(imag, other.imag) == 0;
+}
+
+}
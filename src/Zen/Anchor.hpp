@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+
+#include <gmpxx.h>
+
+#include "DoubleDouble.hpp"
+#include "Vec2.hpp"
+
+namespace Zen
+{
+
+/**
+ * @brief Bits a world coordinate needs at zoom: a pixel is 1 / zoom wide, keep 64 bits below that
+ */
+auto BitsForZoom(const double zoom) -> mp_bitcnt_t;
+
+/**
+ * @brief World point the pixels of a view are counted from, in arbitrary precision.
+ * Pixel p of a view is at anchor + (origin + p) / zoom, so the integer origin only has to reach
+ * across the view and its surroundings, not all the way from the world origin, however deep the zoom is.
+ */
+class Anchor
+{
+public:
+	/**
+	 * @brief The world origin
+	 */
+	Anchor();
+
+	Anchor(const mpf_class &real, const mpf_class &imag);
+
+public:
+	/**
+	 * @brief The point pixels away from this one at zoom, in as many bits as the zoom needs
+	 */
+	auto Moved(const Vec2l &pixels, const double zoom) const -> Anchor;
+
+	/**
+	 * @brief How far this point is from other in pixels at zoom, rounded to whole pixels
+	 * @return false if that does not fit into 64 bit
+	 */
+	auto PixelsFrom(const Anchor &other, const double zoom, Vec2l &pixels) const -> bool;
+
+	auto Real() const -> const mpf_class & { return real; }
+	auto Imag() const -> const mpf_class & { return imag; }
+
+	/**
+	 * @brief Rounded to double-double, the low parts are 0 while the point fits into a double
+	 */
+	auto RealDoubleDouble() const -> DoubleDouble { return realDoubleDouble; }
+	auto ImagDoubleDouble() const -> DoubleDouble { return imagDoubleDouble; }
+
+	/**
+	 * @brief Hash of the value, the same in every run, so tiles counted from it can be stored on disk
+	 */
+	auto Hash() const -> size_t { return hash; }
+
+	auto operator==(const Anchor &other) const -> bool;
+
+private:
+	mpf_class real, imag;
+	DoubleDouble realDoubleDouble, imagDoubleDouble;
+	size_t hash;
+};
+
+}
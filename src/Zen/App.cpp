@@ -25,7 +25,7 @@ void App::Init(const Vec2 &size)
 		size.y,
 		SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 
-	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE | SDL_RENDERER_PRESENTVSYNC);
 
 	InitImGui();
 	running = window && renderer;
@@ -144,56 +144,70 @@ void App::EnableDockSpace()
 void App::HandleEvents()
 {
 	SDL_Event event;
+
+	// nothing changes on screen by itself, so sleep until the user does something.
+	// A few frames after the last event still run, ImGui and the canvas size need them to settle.
+	if (++framesSinceEvent > settleFrames && IsIdle() && SDL_WaitEventTimeout(&event, idleTimeout))
+	{
+		HandleEvent(event);
+	}
+
 	while (SDL_PollEvent(&event))
 	{
-		mouseDelta = Vec2f();
-		mouseWheel = 0;
+		HandleEvent(event);
+	}
+}
 
-		ImGui_ImplSDL2_ProcessEvent(&event);
+void App::HandleEvent(const SDL_Event &event)
+{
+	mouseDelta = Vec2f();
+	mouseWheel = 0;
+	framesSinceEvent = 0;
 
-		switch (event.type)
-		{
-			case SDL_QUIT:
-				running = false;
-				break;
-
-			case SDL_MOUSEBUTTONDOWN:
-				if (event.button.button == SDL_BUTTON_LEFT)
-				{
-					leftMouseDown = true;
-				}
-				if (event.button.button == SDL_BUTTON_RIGHT)
-				{
-					rightMouseDown = true;
-				}
-				OnEvent();
-				break;
-
-			case SDL_MOUSEBUTTONUP:
-				if (event.button.button == SDL_BUTTON_LEFT)
-				{
-					leftMouseDown = false;
-				}
-				if (event.button.button == SDL_BUTTON_RIGHT)
-				{
-					rightMouseDown = false;
-				}
-				OnEvent();
-				break;
-
-			case SDL_MOUSEMOTION:
-				mouseDelta = { (Vec2f::Value_t)event.motion.xrel, (Vec2f::Value_t)event.motion.yrel };
-				OnEvent();
-				break;
-
-			case SDL_MOUSEWHEEL:
-				mouseWheel = event.wheel.y;
-				OnEvent();
-				break;
-
-			default:
-				break;
-		}
+	ImGui_ImplSDL2_ProcessEvent(&event);
+
+	switch (event.type)
+	{
+		case SDL_QUIT:
+			running = false;
+			break;
+
+		case SDL_MOUSEBUTTONDOWN:
+			if (event.button.button == SDL_BUTTON_LEFT)
+			{
+				leftMouseDown = true;
+			}
+			if (event.button.button == SDL_BUTTON_RIGHT)
+			{
+				rightMouseDown = true;
+			}
+			OnEvent();
+			break;
+
+		case SDL_MOUSEBUTTONUP:
+			if (event.button.button == SDL_BUTTON_LEFT)
+			{
+				leftMouseDown = false;
+			}
+			if (event.button.button == SDL_BUTTON_RIGHT)
+			{
+				rightMouseDown = false;
+			}
+			OnEvent();
+			break;
+
+		case SDL_MOUSEMOTION:
+			mouseDelta = { (Vec2f::Value_t)event.motion.xrel, (Vec2f::Value_t)event.motion.yrel };
+			OnEvent();
+			break;
+
+		case SDL_MOUSEWHEEL:
+			mouseWheel = event.wheel.y;
+			OnEvent();
+			break;
+
+		default:
+			break;
 	}
 }
 
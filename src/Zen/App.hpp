@@ -11,23 +11,13 @@
 #include "Complex.hpp"
 #include "Fractals.hpp"
 #include "Canvas.hpp"
+#include "Vec2.hpp"
 
 #define ZEN_UNUSED [[maybe_unused]]
 
 namespace Zen
 {
 
-template<typename T>
-struct BasicVec2
-{
-	using Value_t = T;
-
-	T x = 0, y = 0;
-};
-
-using Vec2 = BasicVec2<int>;
-using Vec2f = BasicVec2<double>;
-
 class App
 {
 public:
@@ -42,6 +32,11 @@ protected:
 	virtual void OnUpdate() {}
 	virtual void OnEvent() {}
 
+	/**
+	 * @brief Return true if nothing would change without user input, the app then waits for events
+	 */
+	virtual bool IsIdle() { return false; }
+
 private:
 	void InitImGui();
 	void QuitImGui();
@@ -51,6 +46,7 @@ private:
 	void DrawFractal();
 
 	void HandleEvents();
+	void HandleEvent(const SDL_Event &event);
 
 protected:
 	std::string appName;
@@ -63,11 +59,14 @@ protected:
 	Vec2 mousePos;
 	Vec2f mouseDelta;
 	int mouseWheel; // 1 = up, 0 = none, -1 = down
+	int idleTimeout = 250; // ms to wait for events while idle
+	int settleFrames = 2;  // frames to run after an event before waiting while idle
 
 private:
 	SDL_Window *window = nullptr;
 	SDL_Renderer *renderer = nullptr;
 	Vec2f canvasTopLeft; // top left position of where the canvas starts in screen space
+	int framesSinceEvent = 0;
 };
 
 }
@@ -1,5 +1,7 @@
 #include "Canvas.hpp"
 
+#include "Grid.hpp"
+
 namespace Zen
 {
 
@@ -23,16 +25,30 @@ void Canvas::ResizeBuffer(const int width, const int height)
 
 	this->width = width;
 	this->height = height;
+	dirty = true;
 }
 
 void Canvas::DrawPoint(const int x, const int y, const SDL_Color &color)
 {
 	const size_t index = y * width + x;
 	buffer[index] = color;
+	dirty = true;
+}
+
+void Canvas::Shift(const int dx, const int dy)
+{
+	ShiftGrid(buffer, width, height, dx, dy, SDL_Color());
+	dirty = true;
 }
 
 void Canvas::Render()
 {
+	if (!dirty)
+	{
+		return;
+	}
+	dirty = false;
+
 	SDL_UpdateTexture(texture, nullptr, buffer.data(), width * sizeof(SDL_Color));
 }
 
@@ -16,6 +16,14 @@ public:
 public:
 	void ResizeBuffer(const int width, const int height);
 	void DrawPoint(const int x, const int y, const SDL_Color &color = { 255, 255, 255, 255 });
+
+	/**
+	 * @brief Move the contents by (dx, dy) pixels, uncovered pixels become transparent
+	 */
+	void Shift(const int dx, const int dy);
+	/**
+	 * @brief Upload the buffer to the texture, if it changed since the last upload
+	 */
 	void Render();
 
 public:
@@ -25,6 +33,7 @@ public:
 private:
 	SDL_Renderer *renderer;
 	std::vector<SDL_Color> buffer;
+	bool dirty = true;
 };
 
 }
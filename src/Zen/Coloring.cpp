@@ -0,0 +1,63 @@
+#include "Coloring.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Hash.hpp"
+
+namespace Zen
+{
+
+auto Fingerprint(const ColorSettings &settings) -> size_t
+{
+	auto hash = HashSeed;
+	hash = HashBytes(hash, settings.palette.data(), settings.palette.size() * sizeof(SDL_Color));
+	hash = HashValue(hash, settings.mapping);
+	hash = HashValue(hash, settings.offset);
+	return hash;
+}
+
+static auto Blend(const SDL_Color &a, const SDL_Color &b, const float t) -> SDL_Color
+{
+	return SDL_Color {
+		(Uint8)(a.r + (b.r - a.r) * t),
+		(Uint8)(a.g + (b.g - a.g) * t),
+		(Uint8)(a.b + (b.b - a.b) * t),
+		(Uint8)(a.a + (b.a - a.a) * t)
+	};
+}
+
+auto Colorize(const ColorSettings &settings, const size_t iterations, const float smooth, const size_t maxIterations) -> SDL_Color
+{
+	const auto &palette = settings.palette;
+	const auto size = palette.size();
+
+	// inside of the set
+	if (iterations >= maxIterations)
+	{
+		return palette.back();
+	}
+
+	const auto shift = settings.offset * size;
+
+	switch (settings.mapping)
+	{
+		case ColorMapping_Smooth:
+		case ColorMapping_Cyclic:
+		{
+			const auto position = settings.mapping == ColorMapping_Smooth
+				? smooth / maxIterations * (size - 1) + shift
+				: smooth + shift;
+
+			const auto wrapped = std::fmod(std::max(position, 0.0f), (float)size);
+			const auto index = (size_t)wrapped % size;
+			return Blend(palette[index], palette[(index + 1) % size], wrapped - std::floor(wrapped));
+		}
+
+		case ColorMapping_Linear:
+		default:
+			return palette[(size_t)((iterations / (float)maxIterations) * (size - 1) + shift) % size];
+	}
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+namespace Zen
+{
+
+/**
+ * @brief How iteration counts are mapped onto the palette.
+ */
+enum ColorMapping : int
+{
+	ColorMapping_Linear, // the whole iteration range spans the palette once
+	ColorMapping_Smooth, // like linear, using the fractional escape iteration and blending palette entries
+	ColorMapping_Cyclic, // every iteration advances one palette entry, repeating the palette
+	ColorMapping_Count
+};
+
+constexpr const char *ColorMappingNames[ColorMapping_Count] = {
+	"Linear",
+	"Smooth",
+	"Cyclic"
+};
+
+/**
+ * @brief Everything that determines how iterations turn into colors.
+ */
+struct ColorSettings
+{
+	std::vector<SDL_Color> palette;
+	ColorMapping mapping = ColorMapping_Linear;
+	float offset = 0.0f; // rotates the palette, in fractions of its size
+};
+
+/**
+ * @brief Hash of the color settings, equal fingerprints mean equal colors.
+ */
+auto Fingerprint(const ColorSettings &settings) -> size_t;
+
+/**
+ * @brief Get the color of a pixel.
+ * @param iterations The escape iteration of the pixel
+ * @param smooth The fractional escape iteration of the pixel
+ * @param maxIterations The iteration limit the pixel was rendered with
+ */
+auto Colorize(const ColorSettings &settings, const size_t iterations, const float smooth, const size_t maxIterations) -> SDL_Color;
+
+}
@@ -2,6 +2,12 @@
 
 #include <ostream>
 #include <cmath>
+#include <cstddef>
+#include <array>
+#include <type_traits>
+
+#include "DoubleDouble.hpp"
+#include "KernelLinkage.hpp"
 
 // only include fmt if it exists
 #if __has_include(<fmt/ostream.h>)
@@ -18,10 +24,14 @@
 
 namespace Zen
 {
+ZEN_KERNEL_LOCAL_BEGIN
 
 template<typename TFloat>
 class BasicComplex;
 
+template<typename TFloat, size_t N>
+struct BasicComplexPack;
+
 template<typename T>
 struct IsComplex_Value
 {
@@ -34,6 +44,12 @@ struct IsComplex_Value<BasicComplex<T>>
 	static auto constexpr value = true;
 };
 
+template<typename T, size_t N>
+struct IsComplex_Value<BasicComplexPack<T, N>>
+{
+	static auto constexpr value = true;
+};
+
 template<typename T>
 constexpr auto IsComplex = IsComplex_Value<T>::value;
 
@@ -201,12 +217,226 @@ std::ostream& operator<<(std::ostream &out, const BasicComplex<TFloat> &complex)
 
 using Complex32 = BasicComplex<float>;
 using Complex64 = BasicComplex<double>;
-using Complex128 = BasicComplex<__float128>;
+using Complex128 = BasicComplex<__float128>; // software emulated, ComplexDoubleDouble is much faster
+using ComplexDoubleDouble = BasicComplex<DoubleDouble>;
 
 #if ZEN_COMPLEX_HAS_GMP
-using ComplexMpz  = BasicComplex<mpz_class>; // TODO(ruarq): Fix segmentation fault issue when using to draw fractals
+/**
+ * @brief Arbitrary precision complex number, for reference orbits.
+ * BasicComplex returns every result as a new value, which with gmp means a heap allocation per temporary,
+ * so this one only has in place operations. They work on temporaries allocated with the number,
+ * iterating doesn't allocate at all. Everything is computed with the precision given on construction.
+ */
+class ComplexMpf
+{
+public:
+	explicit ComplexMpf(const mp_bitcnt_t bits)
+		: ComplexMpf(mpf_class(0, bits), mpf_class(0, bits), bits)
+	{
+	}
+
+	ComplexMpf(const mpf_class &real, const mpf_class &imag, const mp_bitcnt_t bits)
+		: real(real, bits)
+		, imag(imag, bits)
+		, first(0, bits)
+		, second(0, bits)
+		, third(0, bits)
+	{
+	}
+
+public:
+	/**
+	 * @brief this = this + other
+	 */
+	void Add(const ComplexMpf &other)
+	{
+		mpf_add(real.get_mpf_t(), real.get_mpf_t(), other.real.get_mpf_t());
+		mpf_add(imag.get_mpf_t(), imag.get_mpf_t(), other.imag.get_mpf_t());
+	}
+
+	/**
+	 * @brief this = this - other
+	 */
+	void Sub(const ComplexMpf &other)
+	{
+		mpf_sub(real.get_mpf_t(), real.get_mpf_t(), other.real.get_mpf_t());
+		mpf_sub(imag.get_mpf_t(), imag.get_mpf_t(), other.imag.get_mpf_t());
+	}
+
+	/**
+	 * @brief this = this * other
+	 */
+	void Mul(const ComplexMpf &other)
+	{
+		if (&other == this)
+		{
+			Square();
+			return;
+		}
+
+		mpf_mul(first.get_mpf_t(), real.get_mpf_t(), other.real.get_mpf_t());
+		mpf_mul(second.get_mpf_t(), imag.get_mpf_t(), other.imag.get_mpf_t());
+		mpf_mul(third.get_mpf_t(), real.get_mpf_t(), other.imag.get_mpf_t());
+		mpf_mul(imag.get_mpf_t(), imag.get_mpf_t(), other.real.get_mpf_t());
+		mpf_add(imag.get_mpf_t(), imag.get_mpf_t(), third.get_mpf_t());
+		mpf_sub(real.get_mpf_t(), first.get_mpf_t(), second.get_mpf_t());
+	}
+
+	/**
+	 * @brief this = this * this
+	 */
+	void Square()
+	{
+		mpf_mul(first.get_mpf_t(), real.get_mpf_t(), real.get_mpf_t());
+		mpf_mul(second.get_mpf_t(), imag.get_mpf_t(), imag.get_mpf_t());
+		mpf_mul(imag.get_mpf_t(), real.get_mpf_t(), imag.get_mpf_t());
+		mpf_mul_2exp(imag.get_mpf_t(), imag.get_mpf_t(), 1);
+		mpf_sub(real.get_mpf_t(), first.get_mpf_t(), second.get_mpf_t());
+	}
+
+	/**
+	 * @brief Round to double
+	 */
+	auto ToComplex64() const -> BasicComplex<double>
+	{
+		return { real.get_d(), imag.get_d() };
+	}
+
+public:
+	mpf_class real, imag;
+
+private:
+	mpf_class first, second, third;
+};
 #endif
 
 using Complex = BasicComplex<double>;
-	
+
+/**
+ * @brief N complex numbers stored as a real and an imag vector (SoA).
+ * Uses the GCC/Clang vector extensions, so every operator of BasicComplex works lane wise
+ * and compiles down to whatever SIMD instructions the target supports.
+ */
+template<typename TFloat, size_t N>
+struct BasicComplexPack
+{
+public:
+	using TValue = TFloat;
+	typedef TFloat TReal __attribute__((vector_size(sizeof(TFloat) * N)));
+	using TImag = TReal;
+	using TMask = decltype(TReal() > TReal()); // signed integer vector, -1 = true, 0 = false
+	using TMaskValue = std::conditional_t<sizeof(TFloat) == sizeof(int), int, long>; // lane type of TMask
+
+	static constexpr auto Lanes = N;
+
+public:
+	/**
+	 * @brief Default constructor, real=0, imag=0 in every lane
+	 */
+	constexpr BasicComplexPack()
+		: real()
+		, imag()
+	{
+	}
+
+	/**
+	 * @brief Construct a complex pack from real and imag vectors
+	 */
+	constexpr BasicComplexPack(const TReal real, const TImag imag)
+		: real(real)
+		, imag(imag)
+	{
+	}
+
+	/**
+	 * @brief Broadcast a single complex number to every lane
+	 */
+	constexpr BasicComplexPack(const BasicComplex<TFloat> &complex)
+		: real(TReal() + complex.real)
+		, imag(TImag() + complex.imag)
+	{
+	}
+
+	/**
+	 * @brief Gather N complex numbers into a pack
+	 */
+	constexpr BasicComplexPack(const std::array<BasicComplex<TFloat>, N> &complex)
+	{
+		for (size_t lane = 0; lane < N; ++lane)
+		{
+			real[lane] = complex[lane].real;
+			imag[lane] = complex[lane].imag;
+		}
+	}
+
+public:
+	constexpr auto operator+=(const BasicComplexPack<TFloat, N> &other)
+	{
+		*this = Add(*this, other);
+		return *this;
+	}
+
+	constexpr auto operator-=(const BasicComplexPack<TFloat, N> &other)
+	{
+		*this = Sub(*this, other);
+		return *this;
+	}
+
+	constexpr auto operator*=(const BasicComplexPack<TFloat, N> &other)
+	{
+		*this = Mul(*this, other);
+		return *this;
+	}
+
+	/**
+	 * @brief Get a single lane as a complex number
+	 */
+	constexpr auto operator[](const size_t lane) const
+	{
+		return BasicComplex<TFloat>(real[lane], imag[lane]);
+	}
+
+public:
+	TReal real;
+	TImag imag;
+};
+
+/**
+ * @brief Check if any lane of a mask is set
+ */
+template<typename TMask>
+constexpr auto AnyLane(const TMask &mask)
+{
+	for (size_t lane = 0; lane < sizeof(TMask) / sizeof(mask[0]); ++lane)
+	{
+		if (mask[lane])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename TFloat, size_t N>
+std::ostream& operator<<(std::ostream &out, const BasicComplexPack<TFloat, N> &pack)
+{
+	out << "[";
+	for (size_t lane = 0; lane < N; ++lane)
+	{
+		out << (lane > 0 ? ", " : "") << pack[lane];
+	}
+	out << "]";
+	return out;
+}
+
+// Native vector width of the target in bytes
+#if defined(__AVX512F__)
+	#define ZEN_SIMD_BYTES 64
+#elif defined(__AVX__)
+	#define ZEN_SIMD_BYTES 32
+#else
+	#define ZEN_SIMD_BYTES 16
+#endif
+
+ZEN_KERNEL_LOCAL_END
 }
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__AVX2__) && defined(__FMA__)
+	#include <immintrin.h>
+#endif
+
+#include "KernelLinkage.hpp"
+
+namespace Zen
+{
+ZEN_KERNEL_LOCAL_BEGIN
+
+/**
+ * @brief Error free transforms, exact as long as nothing fuses or reorders the operations
+ * (the project builds with -ffp-contract=off, -ffast-math would break them).
+ */
+namespace Eft
+{
+
+/**
+ * @brief a + b = sum + error exactly
+ */
+inline void TwoSum(const double a, const double b, double &sum, double &error)
+{
+	sum = a + b;
+	const auto b2 = sum - a;
+	error = (a - (sum - b2)) + (b - b2);
+}
+
+/**
+ * @brief TwoSum for |a| >= |b|
+ */
+inline void QuickTwoSum(const double a, const double b, double &sum, double &error)
+{
+	sum = a + b;
+	error = b - (sum - a);
+}
+
+/**
+ * @brief a * b = product + error exactly. Dekker's way, the same code on every instruction set:
+ * both are split into 26 bit halves, whose products are exact. TwoProdFma gets the same error with one fma.
+ */
+inline void TwoProd(const double a, const double b, double &product, double &error)
+{
+	constexpr auto Splitter = 134217729.0; // 2^27 + 1
+
+	product = a * b;
+	const auto ta = Splitter * a;
+	const auto aHi = ta - (ta - a);
+	const auto aLo = a - aHi;
+	const auto tb = Splitter * b;
+	const auto bHi = tb - (tb - b);
+	const auto bLo = b - bHi;
+	error = ((aHi * bHi - product) + aHi * bLo + aLo * bHi) + aLo * bLo;
+}
+
+}
+
+/**
+ * @brief Unevaluated sum of two doubles, hi + lo with |lo| <= ulp(hi) / 2, which gives a 106 bit mantissa
+ * in hardware arithmetic. Behaves like a float type, so BasicComplex<DoubleDouble> works with every set.
+ */
+struct DoubleDouble
+{
+public:
+	/**
+	 * @brief Default constructor, 0
+	 */
+	constexpr DoubleDouble()
+		: hi(0.0)
+		, lo(0.0)
+	{
+	}
+
+	constexpr DoubleDouble(const double value)
+		: hi(value)
+		, lo(0.0)
+	{
+	}
+
+	/**
+	 * @brief Construct from a normalized pair, |lo| <= ulp(hi) / 2
+	 */
+	constexpr DoubleDouble(const double hi, const double lo)
+		: hi(hi)
+		, lo(lo)
+	{
+	}
+
+	/**
+	 * @brief Exact for every integer (going through double is not), except within 2^10 of the limits
+	 */
+	static auto FromInteger(const int64_t value) -> DoubleDouble
+	{
+		// hi is value rounded to 53 bits, the rest fits into lo
+		const auto hi = (double)value;
+		return { hi, (double)(value - (int64_t)hi) };
+	}
+
+public:
+	explicit constexpr operator double() const { return hi; }
+
+	auto operator+=(const DoubleDouble &other) -> DoubleDouble &;
+	auto operator-=(const DoubleDouble &other) -> DoubleDouble &;
+	auto operator*=(const DoubleDouble &other) -> DoubleDouble &;
+
+public:
+	double hi, lo;
+};
+
+inline auto operator-(const DoubleDouble &value) -> DoubleDouble
+{
+	return { -value.hi, -value.lo };
+}
+
+inline auto operator+(const DoubleDouble &lhs, const DoubleDouble &rhs) -> DoubleDouble
+{
+	// both halves are added separately, so cancelling hi parts (x * x - y * y) keep the low bits
+	double sum, error, lowSum, lowError;
+	Eft::TwoSum(lhs.hi, rhs.hi, sum, error);
+	Eft::TwoSum(lhs.lo, rhs.lo, lowSum, lowError);
+	error += lowSum;
+	Eft::QuickTwoSum(sum, error, sum, error);
+	error += lowError;
+	Eft::QuickTwoSum(sum, error, sum, error);
+	return { sum, error };
+}
+
+inline auto operator-(const DoubleDouble &lhs, const DoubleDouble &rhs) -> DoubleDouble
+{
+	return lhs + -rhs;
+}
+
+inline auto operator*(const DoubleDouble &lhs, const DoubleDouble &rhs) -> DoubleDouble
+{
+	// lhs.lo * rhs.lo is below the last bit
+	double product, error;
+	Eft::TwoProd(lhs.hi, rhs.hi, product, error);
+	error += lhs.hi * rhs.lo + lhs.lo * rhs.hi;
+	Eft::QuickTwoSum(product, error, product, error);
+	return { product, error };
+}
+
+inline auto operator/(const DoubleDouble &lhs, const double rhs) -> DoubleDouble
+{
+	// long division: the first quotient, then the quotient of what it leaves
+	const auto first = lhs.hi / rhs;
+	double product, productError, rest, restError;
+	Eft::TwoProd(first, rhs, product, productError);
+	Eft::TwoSum(lhs.hi, -product, rest, restError);
+	restError -= productError;
+	restError += lhs.lo;
+	const auto second = (rest + restError) / rhs;
+
+	double sum, error;
+	Eft::QuickTwoSum(first, second, sum, error);
+	return { sum, error };
+}
+
+inline auto DoubleDouble::operator+=(const DoubleDouble &other) -> DoubleDouble &
+{
+	return *this = *this + other;
+}
+
+inline auto DoubleDouble::operator-=(const DoubleDouble &other) -> DoubleDouble &
+{
+	return *this = *this - other;
+}
+
+inline auto DoubleDouble::operator*=(const DoubleDouble &other) -> DoubleDouble &
+{
+	return *this = *this * other;
+}
+
+inline auto operator==(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return lhs.hi == rhs.hi && lhs.lo == rhs.lo;
+}
+
+inline auto operator!=(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return !(lhs == rhs);
+}
+
+inline auto operator<(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return lhs.hi < rhs.hi || (lhs.hi == rhs.hi && lhs.lo < rhs.lo);
+}
+
+inline auto operator>(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return rhs < lhs;
+}
+
+inline auto operator<=(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return !(rhs < lhs);
+}
+
+inline auto operator>=(const DoubleDouble &lhs, const DoubleDouble &rhs) -> bool
+{
+	return !(lhs < rhs);
+}
+
+inline std::ostream& operator<<(std::ostream &out, const DoubleDouble &value)
+{
+	out << "(" << value.hi << " + " << value.lo << ")";
+	return out;
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+/**
+ * @brief 4 double-doubles in AVX registers. Every operation does the exact steps of the DoubleDouble one
+ * (TwoProdFma in place of TwoProd, which is exact either way), so each lane rounds the same as a scalar DoubleDouble would.
+ */
+struct DoubleDouble4
+{
+	__m256d hi, lo;
+};
+
+namespace Eft
+{
+
+inline void TwoSum(const __m256d a, const __m256d b, __m256d &sum, __m256d &error)
+{
+	sum = _mm256_add_pd(a, b);
+	const auto b2 = _mm256_sub_pd(sum, a);
+	error = _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(sum, b2)), _mm256_sub_pd(b, b2));
+}
+
+inline void QuickTwoSum(const __m256d a, const __m256d b, __m256d &sum, __m256d &error)
+{
+	sum = _mm256_add_pd(a, b);
+	error = _mm256_sub_pd(b, _mm256_sub_pd(sum, a));
+}
+
+/**
+ * @brief TwoProd with fma, the error is the exact same
+ */
+inline void TwoProdFma(const __m256d a, const __m256d b, __m256d &product, __m256d &error)
+{
+	product = _mm256_mul_pd(a, b);
+	error = _mm256_fmsub_pd(a, b, product);
+}
+
+}
+
+inline auto Broadcast(const DoubleDouble &value) -> DoubleDouble4
+{
+	return { _mm256_set1_pd(value.hi), _mm256_set1_pd(value.lo) };
+}
+
+/**
+ * @brief Per lane mask ? a : b
+ */
+inline auto Select(const __m256d mask, const DoubleDouble4 &a, const DoubleDouble4 &b) -> DoubleDouble4
+{
+	return { _mm256_blendv_pd(b.hi, a.hi, mask), _mm256_blendv_pd(b.lo, a.lo, mask) };
+}
+
+inline auto operator-(const DoubleDouble4 &value) -> DoubleDouble4
+{
+	const auto sign = _mm256_set1_pd(-0.0);
+	return { _mm256_xor_pd(value.hi, sign), _mm256_xor_pd(value.lo, sign) };
+}
+
+inline auto operator+(const DoubleDouble4 &lhs, const DoubleDouble4 &rhs) -> DoubleDouble4
+{
+	__m256d sum, error, lowSum, lowError;
+	Eft::TwoSum(lhs.hi, rhs.hi, sum, error);
+	Eft::TwoSum(lhs.lo, rhs.lo, lowSum, lowError);
+	error = _mm256_add_pd(error, lowSum);
+	Eft::QuickTwoSum(sum, error, sum, error);
+	error = _mm256_add_pd(error, lowError);
+	Eft::QuickTwoSum(sum, error, sum, error);
+	return { sum, error };
+}
+
+inline auto operator-(const DoubleDouble4 &lhs, const DoubleDouble4 &rhs) -> DoubleDouble4
+{
+	return lhs + -rhs;
+}
+
+inline auto operator*(const DoubleDouble4 &lhs, const DoubleDouble4 &rhs) -> DoubleDouble4
+{
+	__m256d product, error;
+	Eft::TwoProdFma(lhs.hi, rhs.hi, product, error);
+	error = _mm256_add_pd(error, _mm256_add_pd(_mm256_mul_pd(lhs.hi, rhs.lo), _mm256_mul_pd(lhs.lo, rhs.hi)));
+
+	__m256d sum;
+	Eft::QuickTwoSum(product, error, sum, error);
+	return { sum, error };
+}
+
+/**
+ * @return All ones in the lanes where lhs < rhs
+ */
+inline auto operator<(const DoubleDouble4 &lhs, const DoubleDouble4 &rhs) -> __m256d
+{
+	const auto below = _mm256_cmp_pd(lhs.hi, rhs.hi, _CMP_LT_OQ);
+	const auto tie = _mm256_and_pd(_mm256_cmp_pd(lhs.hi, rhs.hi, _CMP_EQ_OQ), _mm256_cmp_pd(lhs.lo, rhs.lo, _CMP_LT_OQ));
+	return _mm256_or_pd(below, tie);
+}
+
+inline auto operator>(const DoubleDouble4 &lhs, const DoubleDouble4 &rhs) -> __m256d
+{
+	return rhs < lhs;
+}
+
+#endif
+
+ZEN_KERNEL_LOCAL_END
+}
@@ -1,13 +1,15 @@
 #pragma once
 
-#include "App.hpp"
+#include <algorithm>
+#include <cmath>
 
-enum FractalId : int
-{
-	FractalId_Mandelbrot,
-	FractalId_Octopus,
-	FractalId_Custom
-};
+#include "App.hpp"
+#include "Coloring.hpp"
+#include "Kernels.hpp"
+#include "Renderer.hpp"
+#include "ThreadPool.hpp"
+#include "TileCache.hpp"
+#include "TileStore.hpp"
 
 class FractalApp : public Zen::App
 {
@@ -17,19 +19,21 @@ private:
 		appName = "Fractals";
 
 		maxIterations = 64;
-		zoom = 100.0;
-		fractal = FractalId_Mandelbrot;
+		zoomLevel = 0;
+		zoom = ZoomAtLevel(zoomLevel);
+		fractal = Zen::FractalId_Mandelbrot;
+		kernels = &Zen::Kernels::Get(Zen::Kernels::DefaultIsa());
 
-		camera = {
-			(-canvas->width / 2.0f) / zoom,
-			(-canvas->height / 2.0f) / zoom
+		origin = {
+			-canvas->width / 2,
+			-canvas->height / 2
 		};
 
 		// Generate color palette
 		for (int i = 255; i > 0; --i)
 		{
 			const float factor = i / 55.0f;
-			colorPalette.push_back({
+			colors.palette.push_back({
 				(uint8_t)(factor * 255),
 				(uint8_t)(factor * 100),
 				(uint8_t)(factor * 50),
@@ -42,21 +46,122 @@ private:
 	{
 		ImGui::Begin("Properties");
 		{
-			ImGui::Text("Zoom %f", zoom);
-			ImGui::Text("Camera (%f, %f)", camera.x, camera.y);
+			ImGui::Text("Zoom %g (level %d)", zoom, zoomLevel);
+			const auto camera = ScreenToWorld({ 0, 0 });
+			ImGui::Text("Camera (%.17g, %.17g)", camera.x, camera.y);
+			ImGui::Text("Precision %s", PerturbationActive() ? Zen::RenderEngineNames[engine] : Zen::PrecisionNames[precision]);
+			if (!PerturbationActive() && !Zen::CanResolve(precision, 1.0 / zoom, ViewMagnitude()))
+			{
+				ImGui::Text("Precision exhausted, zoom out or use perturbation");
+			}
 			
 			ImGui::Text("Fractal");
 			{
-				ImGui::RadioButton("Mandelbrot", (int *)&fractal, FractalId_Mandelbrot);
-				ImGui::RadioButton("Octopus", (int *)&fractal, FractalId_Octopus);
-				ImGui::RadioButton("Custom", (int *)&fractal, FractalId_Custom);
-				if (fractal == FractalId_Custom)
+				ImGui::RadioButton("Mandelbrot", (int *)&fractal, Zen::FractalId_Mandelbrot);
+				ImGui::RadioButton("Octopus", (int *)&fractal, Zen::FractalId_Octopus);
+				ImGui::RadioButton("Custom", (int *)&fractal, Zen::FractalId_Custom);
+				if (fractal == Zen::FractalId_Custom)
 				{
 					ImGui::Text("Not yet supported");
 				}
 			}
 
-			ImGui::SliderInt("Iterations", (int *)&maxIterations, 1, 1 << 11);
+			ImGui::Text("Instruction set");
+			{
+				for (int isa = 0; isa < Zen::Kernels::Isa_Count; ++isa)
+				{
+					if (ImGui::RadioButton(Zen::Kernels::IsaNames[isa], kernels->isa == isa))
+					{
+						kernels = &Zen::Kernels::Get((Zen::Kernels::Isa)isa);
+					}
+				}
+			}
+
+			ImGui::Text("Engine");
+			{
+				for (int i = 0; i < Zen::RenderEngine_Count; ++i)
+				{
+					ImGui::RadioButton(Zen::RenderEngineNames[i], (int *)&engine, i);
+				}
+				if (engine != Zen::RenderEngine_Direct && fractal != Zen::FractalId_Mandelbrot)
+				{
+					ImGui::Text("Mandelbrot only");
+				}
+			}
+
+			ImGui::Text("Algorithm");
+			{
+				for (int i = 0; i < Zen::RenderAlgorithm_Count; ++i)
+				{
+					ImGui::RadioButton(Zen::RenderAlgorithmNames[i], (int *)&algorithm, i);
+				}
+				ImGui::Checkbox("Progressive", &progressive);
+				ImGui::Checkbox("Cycle detection", &periodicity);
+			}
+
+			ImGui::SliderInt("Iterations", (int *)&maxIterations, 1, 1 << 20, "%d", ImGuiSliderFlags_Logarithmic);
+
+			ImGui::Text("Colors");
+			{
+				ImGui::Combo("Mapping", (int *)&colors.mapping, Zen::ColorMappingNames, Zen::ColorMapping_Count);
+				ImGui::SliderFloat("Offset", &colors.offset, 0.0f, 1.0f);
+				ImGui::Checkbox("Cycle", &cycleColors);
+				if (cycleColors)
+				{
+					ImGui::SameLine();
+					ImGui::SliderFloat("Speed", &cycleSpeed, 0.01f, 1.0f);
+
+					colors.offset = std::fmod(colors.offset + cycleSpeed * ImGui::GetIO().DeltaTime, 1.0f);
+				}
+			}
+
+			ImGui::Text("Threads %zu", pool.ThreadCount());
+			const auto stats = renderer.GetStats();
+			if (renderer.IsBusy())
+			{
+				ImGui::Text("Rendering...");
+			}
+			else
+			{
+				ImGui::Text("Done in %.3f s", stats.seconds);
+			}
+
+			ImGui::Text("Iterated %zu px, resumed %zu px", stats.iterated, stats.resumed);
+			ImGui::Text("Filled %zu px, %.1f%% of the view iterated", stats.filled,
+				100.0 * (stats.iterated + stats.resumed) / std::max(canvas->width * canvas->height, 1));
+			if (PerturbationActive())
+			{
+				ImGui::Text("Series skipped %zu iterations", stats.skipped);
+				ImGui::Text("Glitched %zu px, %zu references", stats.glitched, stats.references);
+				ImGui::Text("Corrected %zu px", stats.corrected);
+			}
+
+			ImGui::Text("Tile cache");
+			{
+				const auto cacheStats = cache.GetStats();
+				ImGui::Text("Hits %zu, misses %zu", cacheStats.hits, cacheStats.misses);
+				ImGui::Text("%zu tiles, %.1f MB", cacheStats.tiles, cacheStats.bytes / (1024.0 * 1024.0));
+				if (ImGui::SliderInt("Budget (MB)", &cacheBudget, 0, 4096))
+				{
+					cache.SetBudget((size_t)cacheBudget << 20);
+				}
+				if (ImGui::Button("Clear"))
+				{
+					cache.Clear();
+				}
+
+				if (store.IsOpen())
+				{
+					const auto storeStats = store.GetStats();
+					ImGui::Text("Disk %s", store.GetPath().c_str());
+					ImGui::Text("Disk hits %zu, misses %zu, %zu slots", storeStats.hits, storeStats.misses, storeStats.slots);
+				}
+				else
+				{
+					ImGui::Text("Disk cache unavailable");
+				}
+			}
+
 			ImGui::Text("Average %.3f ms/frame (%.0f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 		}
 		ImGui::End();
@@ -69,30 +174,33 @@ private:
 		HandlePanAndZoom();
 	}
 
+	bool IsIdle() override
+	{
+		return renderer.IsIdle() && !cycleColors;
+	}
+
 	void DrawFractal()
 	{
-		auto iter_fractal = [&](const auto &complex) {
-			switch (fractal)
-			{
-				case FractalId_Mandelbrot: return Zen::Fractals::Mandelbrot::Iter(complex, maxIterations);
-				case FractalId_Octopus: return Zen::Fractals::Octopus::Iter(complex, maxIterations);
-				case FractalId_Custom: return 0ul;
-				default: return Zen::Fractals::Mandelbrot::Iter(complex, maxIterations);
-			}
-		};
+		precision = Zen::SelectPrecision(1.0 / zoom, ViewMagnitude());
 
-		for (int y = 0; y < canvas->height; ++y)
-		{
-			for (int x = 0; x < canvas->width; ++x)
-			{
-				const auto pos = ScreenToWorld({ x, y });
-				const auto start = Zen::Complex64(pos.x, pos.y);
+		const Zen::RenderSettings settings = {
+			fractal,
+			precision,
+			maxIterations,
+			kernels,
+			engine,
+			algorithm,
+			progressive,
+			periodicity,
+			anchor,
+			origin,
+			zoom,
+			canvas->width,
+			canvas->height
+		};
 
-				const auto iterations = iter_fractal(start);
-				const auto color = colorPalette[(iterations / (float)maxIterations) * (colorPalette.size() - 1)];
-				canvas->DrawPoint(x, y, color);
-			}
-		}
+		renderer.Request(settings);
+		renderer.Present(*canvas, colors);
 	}
 
 	void HandlePanAndZoom()
@@ -103,57 +211,142 @@ private:
 			&& mousePos.x <= canvas->width
 			&& mousePos.y <= canvas->height)
 		{
-			// pan
+			// pan, whole pixels only so the previous render can be shifted, the rest is kept for later
 			if (leftMouseDown)
 			{
-				camera.x -= mouseDelta.x / zoom;
-				camera.y -= mouseDelta.y / zoom;
+				panRemainder.x -= mouseDelta.x;
+				panRemainder.y -= mouseDelta.y;
+
+				const auto wholeX = std::trunc(panRemainder.x);
+				const auto wholeY = std::trunc(panRemainder.y);
+				origin.x += (Zen::Vec2l::Value_t)wholeX;
+				origin.y += (Zen::Vec2l::Value_t)wholeY;
+				panRemainder.x -= wholeX;
+				panRemainder.y -= wholeY;
+				Rebase();
 			}
 
 			// zoom
 			if (mouseWheel != 0)
 			{
-				const auto mouseBeforeZoom = ScreenToWorld(mousePos);
+				const auto previousZoom = zoom;
 
-				if (mouseWheel > 0)
-				{
-					zoom *= 1.1f;
-				}
-				else
+				// whole levels only, zooming back out lands on the exact same zoom (and cached tiles)
+				auto level = std::clamp(zoomLevel + (mouseWheel > 0 ? 1 : -1), MinZoomLevel, MaxZoomLevel);
+
+				// the direct kernels stop where double-double can no longer resolve a pixel, only perturbation goes deeper
+				if (level > zoomLevel && !PerturbationActive() && !Zen::CanResolve(Zen::Precision_DoubleDouble, 1.0 / ZoomAtLevel(level), ViewMagnitude()))
 				{
-					zoom *= 0.9f;
+					level = zoomLevel;
 				}
 
-				const auto mouseAfterZoom = ScreenToWorld(mousePos);
-				camera.x += (mouseBeforeZoom.x - mouseAfterZoom.x);
-				camera.y += (mouseBeforeZoom.y - mouseAfterZoom.y);
+				zoomLevel = level;
+				zoom = ZoomAtLevel(zoomLevel);
+
+				// keep the point under the mouse in place, scaling pixels directly,
+				// going through world coordinates in double would lose the position at deep zooms
+				const auto scale = (long double)zoom / previousZoom;
+				origin.x = std::llroundl((long double)(origin.x + mousePos.x) * scale - mousePos.x);
+				origin.y = std::llroundl((long double)(origin.y + mousePos.y) * scale - mousePos.y);
+				panRemainder = {};
+				Rebase();
 			}
 		}
 	}
 
+	/**
+	 * @brief Once origin gets far from the anchor, move the anchor by whole tiles towards it,
+	 * the pixel grid and the tiles on it stay the same
+	 */
+	void Rebase()
+	{
+		if (std::abs(origin.x) < RebaseDistance && std::abs(origin.y) < RebaseDistance)
+		{
+			return;
+		}
+
+		const Zen::Vec2l moved = {
+			origin.x / Zen::Renderer::TileSize * Zen::Renderer::TileSize,
+			origin.y / Zen::Renderer::TileSize * Zen::Renderer::TileSize
+		};
+		anchor = anchor.Moved(moved, zoom);
+		origin.x -= moved.x;
+		origin.y -= moved.y;
+	}
+
+	bool PerturbationActive() const
+	{
+		return engine != Zen::RenderEngine_Direct && fractal == Zen::FractalId_Mandelbrot;
+	}
+
+	/**
+	 * @brief The largest absolute world coordinate in view
+	 */
+	double ViewMagnitude() const
+	{
+		const auto topLeft = ScreenToWorld({ 0, 0 });
+		const auto bottomRight = ScreenToWorld({ canvas->width, canvas->height });
+		return std::max({ std::abs(topLeft.x), std::abs(topLeft.y), std::abs(bottomRight.x), std::abs(bottomRight.y) });
+	}
+
+	static double ZoomAtLevel(const int level)
+	{
+		return BaseZoom * std::pow(ZoomStep, level);
+	}
+
 	Zen::Vec2 WorldToScreen(const Zen::Vec2f &worldCoord) const
 	{
 		return Zen::Vec2 {
-			(Zen::Vec2::Value_t)((worldCoord.x - camera.x) * zoom),
-			(Zen::Vec2::Value_t)((worldCoord.y - camera.y) * zoom)
+			(Zen::Vec2::Value_t)((worldCoord.x - anchor.RealDoubleDouble().hi) * zoom - origin.x),
+			(Zen::Vec2::Value_t)((worldCoord.y - anchor.ImagDoubleDouble().hi) * zoom - origin.y)
 		};
 	}
 
 	Zen::Vec2f ScreenToWorld(const Zen::Vec2 &screenCoord) const
 	{
 		return Zen::Vec2f {
-			screenCoord.x / zoom + camera.x,
-			screenCoord.y / zoom + camera.y
+			anchor.RealDoubleDouble().hi + (origin.x + screenCoord.x) / zoom,
+			anchor.ImagDoubleDouble().hi + (origin.y + screenCoord.y) / zoom
 		};
 	}
 
 private:
-	Zen::Vec2f camera;
+	static constexpr double BaseZoom = 100.0; // pixels per world unit at level 0
+	static constexpr double ZoomStep = 1.1;   // zoom factor between two levels
+
+	// pixels are counted from the anchor, which takes any precision, so the limit is the perturbation deltas:
+	// the series cubes the view radius, which has to stay a normal double (above 1e-308), a zoom of about 1e100.
+	// Without perturbation, zooming stops at about 1e28 already, see HandlePanAndZoom
+	static constexpr int MinZoomLevel = -40;
+	static constexpr int MaxZoomLevel = 2360;
+
+	// distance from the anchor in pixels at which it is moved, far below the 64 bit limit
+	static constexpr int64_t RebaseDistance = (int64_t)1 << 40;
+
+private:
+	Zen::Anchor anchor; // the point origin is counted from, see Zen::Anchor
+	Zen::Vec2l origin; // top left pixel of the view, in pixels from the anchor at the current zoom
+	Zen::Vec2f panRemainder; // sub pixel panning that has not been applied to origin yet
 	SDL_Rect fractalView;
 
 	size_t maxIterations;
+	int zoomLevel;
 	double zoom;
+	Zen::Precision precision = Zen::Precision_Float64;
+
+	Zen::FractalId fractal;
+	const Zen::Kernels::Table *kernels;
+	Zen::RenderEngine engine = Zen::RenderEngine_Direct;
+	Zen::RenderAlgorithm algorithm = Zen::RenderAlgorithm_BruteForce;
+	bool progressive = true;
+	bool periodicity = true;
 
-	FractalId fractal;
-	std::vector<SDL_Color> colorPalette;
+	Zen::ThreadPool pool;
+	int cacheBudget = 256; // MB
+	Zen::TileStore store { Zen::TileStore::DefaultPath(), (size_t)1 << 30, Zen::Renderer::TileSize * Zen::Renderer::TileSize };
+	Zen::TileCache cache { (size_t)cacheBudget << 20, &store };
+	Zen::Renderer renderer { pool, cache };
+	Zen::ColorSettings colors;
+	bool cycleColors = false;
+	float cycleSpeed = 0.1f; // palettes per second
 };
@@ -1,36 +1,423 @@
 #pragma once
 
 #include <cstdint>
+#include <array>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#endif
 
 #include "Complex.hpp"
 
-namespace Zen::Fractals
+namespace Zen
+{
+
+enum FractalId : int
 {
+	FractalId_Mandelbrot,
+	FractalId_Octopus,
+	FractalId_Custom,
+	FractalId_Count
+};
+
+/**
+ * @brief Highest power of z in the expression of each set, escaping orbits grow like |z|^degree.
+ * Custom sets are assumed to be quadratic.
+ */
+constexpr std::array<int, FractalId_Count> FractalDegrees = {
+	2,
+	3,
+	2
+};
 
-#define CREATE_SET_BY_EXPR(name, expr_) \
+}
+
+namespace Zen
+{
+ZEN_KERNEL_LOCAL_BEGIN
+namespace Fractals
+{
+
+/**
+ * @brief Interior test of sets without a closed form one, no point is known to be inside
+ */
+struct NoInterior
+{
+	template<ComplexType TComplex>
+	static constexpr auto Test(const TComplex &c)
+	{
+		return decltype(c.real < c.real)();
+	}
+};
+
+/**
+ * @brief Closed form test for the main cardioid and the period 2 bulb of the Mandelbrot set.
+ * Points inside never escape, so they can skip iterating altogether.
+ */
+struct MainBulbs
+{
+	template<ComplexType TComplex>
+	static constexpr auto Test(const TComplex &c)
+	{
+		using TValue = typename TComplex::TValue;
+		using TReal = typename TComplex::TReal;
+
+		const TReal x = c.real - (TValue)0.25;
+		const TReal y2 = c.imag * c.imag;
+		const TReal q = x * x + y2;
+		const TReal bulbX = c.real + (TValue)1.0;
+
+		const auto cardioid = q * (q + x) < (TValue)0.25 * y2;
+		const auto bulb = bulbX * bulbX + y2 < (TValue)0.0625;
+		return cardioid | bulb;
+	}
+};
+
+/**
+ * @brief Create an escape time set from an expression in z and c.
+ * Generates Iter for a single complex number and IterN, which runs the same expression
+ * on a BasicComplexPack and masks out lanes once they escaped.
+ * The overloads taking z and a start iteration continue an earlier call: z is the value
+ * after the last iteration (at escape, or when the limit was hit), which also drives smooth coloring.
+ * Points that interior_::Test finds inside the set get max_iter right away, their z is not advanced.
+ * With a tolerance above 0, orbits are checked for cycles (Brent): z is compared to a reference
+ * that is moved to the current z after 1, 2, 4, 8... iterations, coming back within tolerance
+ * means the point is caught in a cycle and gets max_iter as well.
+ */
+#define CREATE_SET(name, expr_, interior_) \
 	namespace name { \
 		static constexpr auto expr = #expr_; \
+		using Interior = interior_; \
 		template<ComplexType TComplex> \
-		auto Iter(const TComplex &start, const size_t max_iter) -> size_t \
+		auto Iter(const TComplex &c, TComplex &z, const size_t first_iter, const size_t max_iter, const typename TComplex::TValue tolerance = 0) -> size_t \
 		{ \
-			const auto c = start; \
-			auto z = start; \
-			for (size_t i = 0; i < max_iter; ++i) \
+			if (Interior::Test(c)) \
+			{ \
+				return max_iter; \
+			} \
+			const auto toleranceSq = tolerance * tolerance; \
+			auto reference = z; \
+			size_t step = 0, period = 1; \
+			for (size_t i = first_iter; i < max_iter; ++i) \
 			{ \
 				z = expr_; \
 				if (AbsSq(z) > 4.0) \
 				{ \
 					return i; \
 				} \
+				if (tolerance > 0) \
+				{ \
+					if (AbsSq(z - reference) < toleranceSq) \
+					{ \
+						return max_iter; \
+					} \
+					if (++step == period) \
+					{ \
+						reference = z; \
+						step = 0; \
+						period *= 2; \
+					} \
+				} \
 			} \
 			return max_iter; \
 		} \
+		template<ComplexType TComplex> \
+		auto Iter(const TComplex &start, const size_t max_iter) -> size_t \
+		{ \
+			auto z = start; \
+			return Iter(start, z, 0, max_iter); \
+		} \
+		template<typename TFloat, size_t N> \
+		void IterN(const BasicComplexPack<TFloat, N> &c, BasicComplexPack<TFloat, N> &z, typename BasicComplexPack<TFloat, N>::TMask &count, const size_t max_iter, const TFloat tolerance = 0) \
+		{ \
+			using TPack = BasicComplexPack<TFloat, N>; \
+			const auto limit = typename TPack::TMask() + (typename TPack::TMaskValue)max_iter; \
+			const auto toleranceSq = tolerance * tolerance; \
+			auto active = count < limit; \
+			count = (Interior::Test(c) & active) ? limit : count; \
+			active = count < limit; \
+			auto reference = z; \
+			size_t step = 0, period = 1; \
+			while (AnyLane(active)) \
+			{ \
+				const auto next = expr_; \
+				z.real = active ? next.real : z.real; \
+				z.imag = active ? next.imag : z.imag; \
+				active &= ~(AbsSq(z) > (TFloat)4.0); \
+				count -= active; \
+				if (tolerance > 0) \
+				{ \
+					const auto cycle = active & (AbsSq(z - reference) < toleranceSq); \
+					count = cycle ? limit : count; \
+					if (++step == period) \
+					{ \
+						reference = z; \
+						step = 0; \
+						period *= 2; \
+					} \
+				} \
+				active &= count < limit; \
+			} \
+		} \
+		template<typename TFloat, size_t N> \
+		auto IterN(const BasicComplexPack<TFloat, N> &start, const size_t max_iter) -> std::array<size_t, N> \
+		{ \
+			auto z = start; \
+			auto count = typename BasicComplexPack<TFloat, N>::TMask(); \
+			IterN(start, z, count, max_iter); \
+			std::array<size_t, N> result; \
+			for (size_t lane = 0; lane < N; ++lane) \
+			{ \
+				result[lane] = count[lane]; \
+			} \
+			return result; \
+		} \
+	}
+
+/**
+ * @brief CREATE_SET for sets without an interior test
+ */
+#define CREATE_SET_BY_EXPR(name, expr_) CREATE_SET(name, expr_, NoInterior)
+
+CREATE_SET(Mandelbrot, z * z + c, MainBulbs);
+
+#if defined(__AVX2__)
+namespace Mandelbrot
+{
+
+/**
+ * @brief IterN on 4 points using hand written AVX2.
+ * Lanes that escaped are masked out, so every lane ends with the exact same count and z
+ * as Iter would for that point, cycle detection included.
+ */
+inline void Iter4(const BasicComplexPack<double, 4> &c, BasicComplexPack<double, 4> &z, BasicComplexPack<double, 4>::TMask &count, const size_t max_iter, const double tolerance = 0)
+{
+	const auto cr = (__m256d)c.real;
+	const auto ci = (__m256d)c.imag;
+	const auto bailout = _mm256_set1_pd(4.0);
+	const auto limit = _mm256_set1_epi64x((long long)max_iter);
+	const auto toleranceSq = _mm256_set1_pd(tolerance * tolerance);
+
+	auto zr = (__m256d)z.real;
+	auto zi = (__m256d)z.imag;
+	auto n = (__m256i)count;
+	auto active = _mm256_castsi256_pd(_mm256_cmpgt_epi64(limit, n));
+
+	// MainBulbs::Test, inside lanes jump to the limit
+	{
+		const auto x = _mm256_sub_pd(cr, _mm256_set1_pd(0.25));
+		const auto y2 = _mm256_mul_pd(ci, ci);
+		const auto q = _mm256_add_pd(_mm256_mul_pd(x, x), y2);
+		const auto bulbX = _mm256_add_pd(cr, _mm256_set1_pd(1.0));
+		const auto cardioid = _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, x)), _mm256_mul_pd(_mm256_set1_pd(0.25), y2), _CMP_LT_OQ);
+		const auto bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(bulbX, bulbX), y2), _mm256_set1_pd(0.0625), _CMP_LT_OQ);
+		const auto interior = _mm256_and_pd(_mm256_or_pd(cardioid, bulb), active);
+
+		n = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(n), _mm256_castsi256_pd(limit), interior));
+		active = _mm256_andnot_pd(interior, active);
 	}
 
-CREATE_SET_BY_EXPR(Mandelbrot, z * z + c);
+	auto referenceR = zr;
+	auto referenceI = zi;
+	size_t step = 0, period = 1;
+
+	while (!_mm256_testz_pd(active, active))
+	{
+		// same operation order as Mul + Add on Complex64, so rounding matches the scalar path
+		const auto zrzi = _mm256_mul_pd(zr, zi);
+		const auto nextr = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(zr, zr), _mm256_mul_pd(zi, zi)), cr);
+		const auto nexti = _mm256_add_pd(_mm256_add_pd(zrzi, zrzi), ci);
+
+		// escaped lanes keep their last value
+		zr = _mm256_blendv_pd(zr, nextr, active);
+		zi = _mm256_blendv_pd(zi, nexti, active);
+
+		const auto absSq = _mm256_add_pd(_mm256_mul_pd(zr, zr), _mm256_mul_pd(zi, zi));
+		active = _mm256_andnot_pd(_mm256_cmp_pd(absSq, bailout, _CMP_GT_OQ), active);
+
+		// active lanes are all ones (-1), so subtracting them counts the iteration
+		n = _mm256_sub_epi64(n, _mm256_castpd_si256(active));
+
+		// Brent, step and period are the same for every lane that is still going
+		if (tolerance > 0)
+		{
+			const auto dr = _mm256_sub_pd(zr, referenceR);
+			const auto di = _mm256_sub_pd(zi, referenceI);
+			const auto distanceSq = _mm256_add_pd(_mm256_mul_pd(dr, dr), _mm256_mul_pd(di, di));
+			const auto cycle = _mm256_and_pd(active, _mm256_cmp_pd(distanceSq, toleranceSq, _CMP_LT_OQ));
+			n = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(n), _mm256_castsi256_pd(limit), cycle));
+
+			if (++step == period)
+			{
+				referenceR = zr;
+				referenceI = zi;
+				step = 0;
+				period *= 2;
+			}
+		}
+
+		active = _mm256_and_pd(active, _mm256_castsi256_pd(_mm256_cmpgt_epi64(limit, n)));
+	}
+
+	z = BasicComplexPack<double, 4>(zr, zi);
+	count = (BasicComplexPack<double, 4>::TMask)n;
+}
+
+/**
+ * @brief IterN on 8 single precision points using hand written AVX2.
+ * Same masking scheme as Iter4, every lane matches Iter on a Complex32.
+ */
+inline void Iter8(const BasicComplexPack<float, 8> &c, BasicComplexPack<float, 8> &z, BasicComplexPack<float, 8>::TMask &count, const size_t max_iter, const float tolerance = 0)
+{
+	const auto cr = (__m256)c.real;
+	const auto ci = (__m256)c.imag;
+	const auto bailout = _mm256_set1_ps(4.0f);
+	const auto limit = _mm256_set1_epi32((int)max_iter);
+	const auto toleranceSq = _mm256_set1_ps(tolerance * tolerance);
+
+	auto zr = (__m256)z.real;
+	auto zi = (__m256)z.imag;
+	auto n = (__m256i)count;
+	auto active = _mm256_castsi256_ps(_mm256_cmpgt_epi32(limit, n));
+
+	// MainBulbs::Test
+	{
+		const auto x = _mm256_sub_ps(cr, _mm256_set1_ps(0.25f));
+		const auto y2 = _mm256_mul_ps(ci, ci);
+		const auto q = _mm256_add_ps(_mm256_mul_ps(x, x), y2);
+		const auto bulbX = _mm256_add_ps(cr, _mm256_set1_ps(1.0f));
+		const auto cardioid = _mm256_cmp_ps(_mm256_mul_ps(q, _mm256_add_ps(q, x)), _mm256_mul_ps(_mm256_set1_ps(0.25f), y2), _CMP_LT_OQ);
+		const auto bulb = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(bulbX, bulbX), y2), _mm256_set1_ps(0.0625f), _CMP_LT_OQ);
+		const auto interior = _mm256_and_ps(_mm256_or_ps(cardioid, bulb), active);
+
+		n = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(n), _mm256_castsi256_ps(limit), interior));
+		active = _mm256_andnot_ps(interior, active);
+	}
+
+	auto referenceR = zr;
+	auto referenceI = zi;
+	size_t step = 0, period = 1;
+
+	while (!_mm256_testz_ps(active, active))
+	{
+		const auto zrzi = _mm256_mul_ps(zr, zi);
+		const auto nextr = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(zr, zr), _mm256_mul_ps(zi, zi)), cr);
+		const auto nexti = _mm256_add_ps(_mm256_add_ps(zrzi, zrzi), ci);
+
+		zr = _mm256_blendv_ps(zr, nextr, active);
+		zi = _mm256_blendv_ps(zi, nexti, active);
+
+		const auto absSq = _mm256_add_ps(_mm256_mul_ps(zr, zr), _mm256_mul_ps(zi, zi));
+		active = _mm256_andnot_ps(_mm256_cmp_ps(absSq, bailout, _CMP_GT_OQ), active);
+
+		n = _mm256_sub_epi32(n, _mm256_castps_si256(active));
+
+		if (tolerance > 0)
+		{
+			const auto dr = _mm256_sub_ps(zr, referenceR);
+			const auto di = _mm256_sub_ps(zi, referenceI);
+			const auto distanceSq = _mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(di, di));
+			const auto cycle = _mm256_and_ps(active, _mm256_cmp_ps(distanceSq, toleranceSq, _CMP_LT_OQ));
+			n = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(n), _mm256_castsi256_ps(limit), cycle));
+
+			if (++step == period)
+			{
+				referenceR = zr;
+				referenceI = zi;
+				step = 0;
+				period *= 2;
+			}
+		}
+
+		active = _mm256_and_ps(active, _mm256_castsi256_ps(_mm256_cmpgt_epi32(limit, n)));
+	}
+
+	z = BasicComplexPack<float, 8>(zr, zi);
+	count = (BasicComplexPack<float, 8>::TMask)n;
+}
+
+#if defined(__FMA__)
+/**
+ * @brief IterN on 4 double-double points using hand written AVX2, the low parts double the cost of every operation
+ * but stay in hardware. Same masking scheme as Iter4, every lane matches Iter on a ComplexDoubleDouble.
+ */
+inline void Iter4(const DoubleDouble4 &cr, const DoubleDouble4 &ci, DoubleDouble4 &zr, DoubleDouble4 &zi, BasicComplexPack<double, 4>::TMask &count, const size_t max_iter, const double tolerance = 0)
+{
+	const auto bailout = Broadcast(4.0);
+	const auto limit = _mm256_set1_epi64x((long long)max_iter);
+	const auto toleranceSq = Broadcast(DoubleDouble(tolerance) * DoubleDouble(tolerance));
+
+	auto n = (__m256i)count;
+	auto active = _mm256_castsi256_pd(_mm256_cmpgt_epi64(limit, n));
+
+	// MainBulbs::Test, in double-double like the scalar one
+	{
+		const auto x = cr - Broadcast(0.25);
+		const auto y2 = ci * ci;
+		const auto q = x * x + y2;
+		const auto bulbX = cr + Broadcast(1.0);
+		const auto cardioid = q * (q + x) < Broadcast(0.25) * y2;
+		const auto bulb = bulbX * bulbX + y2 < Broadcast(0.0625);
+		const auto interior = _mm256_and_pd(_mm256_or_pd(cardioid, bulb), active);
+
+		n = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(n), _mm256_castsi256_pd(limit), interior));
+		active = _mm256_andnot_pd(interior, active);
+	}
+
+	// the squares of z are needed by both the next z and the escape test, so they are only computed once
+	auto zr2 = zr * zr;
+	auto zi2 = zi * zi;
+
+	auto referenceR = zr;
+	auto referenceI = zi;
+	size_t step = 0, period = 1;
+
+	while (!_mm256_testz_pd(active, active))
+	{
+		// zr * zi + zi * zr, doubling is exact and both products are the same
+		const auto zrzi = zr * zi;
+		const auto nextr = (zr2 - zi2) + cr;
+		const auto nexti = DoubleDouble4 { _mm256_add_pd(zrzi.hi, zrzi.hi), _mm256_add_pd(zrzi.lo, zrzi.lo) } + ci;
+
+		zr = Select(active, nextr, zr);
+		zi = Select(active, nexti, zi);
+		zr2 = zr * zr;
+		zi2 = zi * zi;
+
+		active = _mm256_andnot_pd(zr2 + zi2 > bailout, active);
+
+		n = _mm256_sub_epi64(n, _mm256_castpd_si256(active));
+
+		if (tolerance > 0)
+		{
+			const auto dr = zr - referenceR;
+			const auto di = zi - referenceI;
+			const auto cycle = _mm256_and_pd(active, dr * dr + di * di < toleranceSq);
+			n = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(n), _mm256_castsi256_pd(limit), cycle));
+
+			if (++step == period)
+			{
+				referenceR = zr;
+				referenceI = zi;
+				step = 0;
+				period *= 2;
+			}
+		}
+
+		active = _mm256_and_pd(active, _mm256_castsi256_pd(_mm256_cmpgt_epi64(limit, n)));
+	}
+
+	count = (BasicComplexPack<double, 4>::TMask)n;
+}
+#endif
+
+}
+#endif
 
 // Some sets I found by myself (they obviously probably have already been found, but I gave them my own names)
 
 CREATE_SET_BY_EXPR(Octopus, (c + z) * z + z * z * z + c * z * z + z);
 
 }
+ZEN_KERNEL_LOCAL_END
+}
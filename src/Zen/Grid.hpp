@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace Zen
+{
+
+/**
+ * @brief Move the contents of a row major width x height grid by (dx, dy) in place.
+ * Cells uncovered by the move are set to fill.
+ */
+template<typename T>
+void ShiftGrid(std::vector<T> &grid, const int width, const int height, const int dx, const int dy, const T &fill)
+{
+	if (std::abs(dx) >= width || std::abs(dy) >= height)
+	{
+		std::fill(grid.begin(), grid.end(), fill);
+		return;
+	}
+
+	// columns of a row that stay visible, before (src) and after (dst) the move
+	const auto srcBegin = std::max(0, -dx);
+	const auto srcEnd = std::min(width, width - dx);
+	const auto dstBegin = srcBegin + dx;
+
+	auto move_row = [&](const int y) {
+		auto *src = &grid[(y - dy) * width];
+		auto *dst = &grid[y * width];
+
+		if (dx > 0)
+		{
+			std::move_backward(src + srcBegin, src + srcEnd, dst + srcEnd + dx);
+		}
+		else
+		{
+			std::move(src + srcBegin, src + srcEnd, dst + dstBegin);
+		}
+
+		std::fill(dst, dst + std::max(0, dx), fill);
+		std::fill(dst + std::min(width, width + dx), dst + width, fill);
+	};
+
+	// walk against the direction of the move, so no row is overwritten before it was moved
+	if (dy > 0)
+	{
+		for (int y = height - 1; y >= dy; --y)
+		{
+			move_row(y);
+		}
+		std::fill(grid.begin(), grid.begin() + dy * width, fill);
+	}
+	else
+	{
+		for (int y = 0; y < height + dy; ++y)
+		{
+			move_row(y);
+		}
+		std::fill(grid.begin() + (height + dy) * width, grid.begin() + height * width, fill);
+	}
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Zen
+{
+
+constexpr size_t HashSeed = 0xcbf29ce484222325ull;
+
+/**
+ * @brief FNV-1a hash of size bytes, continuing from hash
+ */
+inline auto HashBytes(size_t hash, const void *data, const size_t size) -> size_t
+{
+	const auto bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/**
+ * @brief Hash the bytes of a value without padding
+ */
+template<typename T>
+inline auto HashValue(const size_t hash, const T &value) -> size_t
+{
+	return HashBytes(hash, &value, sizeof(value));
+}
+
+}
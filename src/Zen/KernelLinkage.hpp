@@ -0,0 +1,16 @@
+#pragma once
+
+// The kernel units (Zen/Kernels/*.cpp) are built once per instruction set, each with its own -m flags.
+// Every inline function and template they use from the math headers is emitted into each of them, and with
+// external linkage the linker keeps one arbitrary copy for all units, so the SSE2 kernels could end up running
+// AVX-512 code. Those units define ZEN_KERNEL_UNIT before any include (see Kernels/Impl.hpp), which puts
+// the contents of the math headers into an unnamed namespace there: every unit keeps its own copies.
+// Anything crossing the unit boundary (Kernels.hpp) has to stay outside of it. What remains shared are standard
+// library helpers (std::min, std::array accessors without optimization), integer code that is the same on every set.
+#if defined(ZEN_KERNEL_UNIT)
+	#define ZEN_KERNEL_LOCAL_BEGIN namespace {
+	#define ZEN_KERNEL_LOCAL_END }
+#else
+	#define ZEN_KERNEL_LOCAL_BEGIN
+	#define ZEN_KERNEL_LOCAL_END
+#endif
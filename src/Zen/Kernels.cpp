@@ -0,0 +1,80 @@
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+
+namespace Zen::Kernels
+{
+
+namespace Sse2 { auto GetTable() -> Table; }
+namespace Avx2 { auto GetTable() -> Table; }
+namespace Avx512 { auto GetTable() -> Table; }
+
+auto DetectIsa() -> Isa
+{
+	__builtin_cpu_init();
+
+	// Kernels/Avx512.cpp is built with -mavx512dq (which some AVX-512 cpus, like Knights Landing, lack) and -mfma
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("fma"))
+	{
+		return Isa_Avx512;
+	}
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return Isa_Avx2;
+	}
+
+	return Isa_Sse2;
+}
+
+auto DefaultIsa() -> Isa
+{
+	const auto detected = DetectIsa();
+
+	const char *forced = std::getenv("ZEN_ISA");
+	if (!forced)
+	{
+		return detected;
+	}
+
+	const auto name = std::string_view(forced);
+	if (name == "sse2")
+	{
+		return Isa_Sse2;
+	}
+	if (name == "avx2")
+	{
+		return std::min(Isa_Avx2, detected);
+	}
+
+	return detected;
+}
+
+auto Get(const Isa isa) -> const Table &
+{
+	// built on first use only, GetTable itself is compiled for its instruction set and may not run on this host
+	switch (std::min(isa, DetectIsa()))
+	{
+		case Isa_Avx512:
+		{
+			static const auto table = Avx512::GetTable();
+			return table;
+		}
+
+		case Isa_Avx2:
+		{
+			static const auto table = Avx2::GetTable();
+			return table;
+		}
+
+		default:
+		{
+			static const auto table = Sse2::GetTable();
+			return table;
+		}
+	}
+}
+
+}
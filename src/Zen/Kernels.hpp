@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Fractals.hpp"
+#include "Precision.hpp"
+
+namespace Zen::Kernels
+{
+
+/**
+ * @brief Instruction sets the kernels are compiled for, ordered from narrowest to widest.
+ */
+enum Isa : int
+{
+	Isa_Sse2,
+	Isa_Avx2,
+	Isa_Avx512,
+	Isa_Count
+};
+
+constexpr std::array<const char *, Isa_Count> IsaNames = {
+	"SSE2",
+	"AVX2",
+	"AVX-512"
+};
+
+/**
+ * @brief A batch of independent points to iterate.
+ * Points can be continued from an earlier batch with a lower maxIter, as long as they did not escape.
+ */
+struct Batch
+{
+	const double *real; // real part of c for every point
+	const double *imag; // imaginary part of c for every point
+	double *zReal;      // z to continue from (c for new points), z after the last iteration on return
+	double *zImag;
+	size_t *iterations; // iteration to continue from (0 for new points), escape iteration on return
+	size_t count;
+	size_t maxIter;
+	double tolerance;   // distance at which an orbit counts as cycling, see CREATE_SET, 0 disables the check
+
+	// low parts of c for precisions beyond double (c = real + realLo), nullptr means 0.
+	// z is only kept in double, so points continued in such a precision lose their low parts
+	const double *realLo = nullptr;
+	const double *imagLo = nullptr;
+};
+
+using IterateFn = void (*)(const Batch &batch);
+
+/**
+ * @brief Kernels of one instruction set, indexed by fractal and precision.
+ * Fractals without a kernel (FractalId_Custom) are nullptr.
+ */
+struct Table
+{
+	Isa isa;
+	std::array<std::array<IterateFn, Precision_Count>, FractalId_Count> iterate;
+};
+
+/**
+ * @brief The widest instruction set the host cpu supports.
+ */
+auto DetectIsa() -> Isa;
+
+/**
+ * @brief The instruction set used by default: DetectIsa, unless the ZEN_ISA environment
+ * variable (sse2, avx2 or avx512) forces a narrower one for testing.
+ */
+auto DefaultIsa() -> Isa;
+
+/**
+ * @brief Get the kernels for an instruction set. Falls back to DetectIsa if the host can't run it.
+ */
+auto Get(Isa isa) -> const Table &;
+
+}
@@ -0,0 +1,32 @@
+#include "Impl.hpp"
+
+namespace Zen::Kernels::Avx2
+{
+
+auto GetTable() -> Table
+{
+	Table table = { Isa_Avx2, {} };
+
+	// hand written kernels for the hottest set
+	table.iterate[FractalId_Mandelbrot][Precision_Float32] = [](const Batch &batch) {
+		Impl::IterateBatch<float, 8>(batch, [](const auto &c, auto &z, auto &count, const size_t max_iter, const float tolerance) {
+			Fractals::Mandelbrot::Iter8(c, z, count, max_iter, tolerance);
+		});
+	};
+	table.iterate[FractalId_Mandelbrot][Precision_Float64] = [](const Batch &batch) {
+		Impl::IterateBatch<double, 4>(batch, [](const auto &c, auto &z, auto &count, const size_t max_iter, const double tolerance) {
+			Fractals::Mandelbrot::Iter4(c, z, count, max_iter, tolerance);
+		});
+	};
+	table.iterate[FractalId_Octopus][Precision_Float32] = ZEN_KERNEL_ITER_N(Octopus, float);
+	table.iterate[FractalId_Octopus][Precision_Float64] = ZEN_KERNEL_ITER_N(Octopus, double);
+
+	table.iterate[FractalId_Mandelbrot][Precision_DoubleDouble] = Impl::IterateMandelbrotDoubleDouble;
+
+	// double-double doesn't fit into vector extension packs
+	table.iterate[FractalId_Octopus][Precision_DoubleDouble] = ZEN_KERNEL_ITER(Octopus, DoubleDouble);
+
+	return table;
+}
+
+}
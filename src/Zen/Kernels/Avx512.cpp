@@ -0,0 +1,23 @@
+#include "Impl.hpp"
+
+namespace Zen::Kernels::Avx512
+{
+
+auto GetTable() -> Table
+{
+	Table table = { Isa_Avx512, {} };
+
+	table.iterate[FractalId_Mandelbrot][Precision_Float32] = ZEN_KERNEL_ITER_N(Mandelbrot, float);
+	table.iterate[FractalId_Mandelbrot][Precision_Float64] = ZEN_KERNEL_ITER_N(Mandelbrot, double);
+	table.iterate[FractalId_Octopus][Precision_Float32] = ZEN_KERNEL_ITER_N(Octopus, float);
+	table.iterate[FractalId_Octopus][Precision_Float64] = ZEN_KERNEL_ITER_N(Octopus, double);
+
+	table.iterate[FractalId_Mandelbrot][Precision_DoubleDouble] = Impl::IterateMandelbrotDoubleDouble;
+
+	// double-double doesn't fit into vector extension packs
+	table.iterate[FractalId_Octopus][Precision_DoubleDouble] = ZEN_KERNEL_ITER(Octopus, DoubleDouble);
+
+	return table;
+}
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+// Shared kernel implementation, included first by every instruction set specific translation unit.
+// Each of those units is compiled with its own -m flags, so the packs below get the native width
+// of that instruction set. Everything they instantiate from here and from the math headers has internal
+// linkage (see KernelLinkage.hpp), so the linker can't swap in the copy of another instruction set.
+
+#define ZEN_KERNEL_UNIT
+
+#include <algorithm>
+
+#include "../Kernels.hpp"
+
+namespace Zen::Kernels::Impl
+{
+namespace
+{
+
+/**
+ * @brief Iterate a batch in packs of N, using iter_n for every pack.
+ * The last pack is padded with copies of the last point, so no scalar tail is needed.
+ */
+template<typename TFloat, size_t N, typename TIterN>
+inline void IterateBatch(const Batch &batch, TIterN iter_n)
+{
+	using TPack = BasicComplexPack<TFloat, N>;
+
+	for (size_t first = 0; first < batch.count; first += N)
+	{
+		TPack c, z;
+		typename TPack::TMask count;
+		for (size_t lane = 0; lane < N; ++lane)
+		{
+			const auto index = std::min(first + lane, batch.count - 1);
+			c.real[lane] = (TFloat)batch.real[index];
+			c.imag[lane] = (TFloat)batch.imag[index];
+			z.real[lane] = (TFloat)batch.zReal[index];
+			z.imag[lane] = (TFloat)batch.zImag[index];
+			count[lane] = (typename TPack::TMaskValue)batch.iterations[index];
+		}
+
+		iter_n(c, z, count, batch.maxIter, (TFloat)batch.tolerance);
+
+		for (size_t lane = 0; lane < N && first + lane < batch.count; ++lane)
+		{
+			batch.zReal[first + lane] = z.real[lane];
+			batch.zImag[first + lane] = z.imag[lane];
+			batch.iterations[first + lane] = count[lane];
+		}
+	}
+}
+
+/**
+ * @brief Iterate a batch one point at a time with iter, for float types that don't fit into packs.
+ * c gets its low parts, new points start at the full c, continued ones only at z in double.
+ */
+template<typename TFloat, typename TIter>
+inline void IterateBatchScalar(const Batch &batch, TIter iter)
+{
+	using TComplex = BasicComplex<TFloat>;
+
+	for (size_t index = 0; index < batch.count; ++index)
+	{
+		auto c = TComplex(batch.real[index], batch.imag[index]);
+		if (batch.realLo && batch.imagLo)
+		{
+			c += TComplex(batch.realLo[index], batch.imagLo[index]);
+		}
+
+		auto z = batch.iterations[index] == 0 ? c : TComplex(batch.zReal[index], batch.zImag[index]);
+		batch.iterations[index] = iter(c, z, batch.iterations[index], batch.maxIter, (TFloat)batch.tolerance);
+		batch.zReal[index] = (double)z.real;
+		batch.zImag[index] = (double)z.imag;
+	}
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+/**
+ * @brief Iterate a batch of double-double Mandelbrot points in packs of 4, starting like IterateBatchScalar
+ * and padding like IterateBatch.
+ */
+inline void IterateMandelbrotDoubleDouble(const Batch &batch)
+{
+	for (size_t first = 0; first < batch.count; first += 4)
+	{
+		alignas(32) double lanes[8][4];
+		alignas(32) int64_t count[4];
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			const auto index = std::min(first + lane, batch.count - 1);
+			auto c = ComplexDoubleDouble(batch.real[index], batch.imag[index]);
+			if (batch.realLo && batch.imagLo)
+			{
+				c += ComplexDoubleDouble(batch.realLo[index], batch.imagLo[index]);
+			}
+
+			const auto z = batch.iterations[index] == 0 ? c : ComplexDoubleDouble(batch.zReal[index], batch.zImag[index]);
+			lanes[0][lane] = c.real.hi;
+			lanes[1][lane] = c.real.lo;
+			lanes[2][lane] = c.imag.hi;
+			lanes[3][lane] = c.imag.lo;
+			lanes[4][lane] = z.real.hi;
+			lanes[5][lane] = z.real.lo;
+			lanes[6][lane] = z.imag.hi;
+			lanes[7][lane] = z.imag.lo;
+			count[lane] = (int64_t)batch.iterations[index];
+		}
+
+		const auto cr = DoubleDouble4 { _mm256_load_pd(lanes[0]), _mm256_load_pd(lanes[1]) };
+		const auto ci = DoubleDouble4 { _mm256_load_pd(lanes[2]), _mm256_load_pd(lanes[3]) };
+		auto zr = DoubleDouble4 { _mm256_load_pd(lanes[4]), _mm256_load_pd(lanes[5]) };
+		auto zi = DoubleDouble4 { _mm256_load_pd(lanes[6]), _mm256_load_pd(lanes[7]) };
+		auto n = (BasicComplexPack<double, 4>::TMask)_mm256_load_si256((const __m256i *)count);
+
+		Fractals::Mandelbrot::Iter4(cr, ci, zr, zi, n, batch.maxIter, batch.tolerance);
+
+		_mm256_store_pd(lanes[4], zr.hi);
+		_mm256_store_pd(lanes[6], zi.hi);
+		for (size_t lane = 0; lane < 4 && first + lane < batch.count; ++lane)
+		{
+			batch.zReal[first + lane] = lanes[4][lane];
+			batch.zImag[first + lane] = lanes[6][lane];
+			batch.iterations[first + lane] = (size_t)n[lane];
+		}
+	}
+}
+#endif
+
+/**
+ * @brief Generic kernel of a CREATE_SET_BY_EXPR set, running its scalar Iter point by point.
+ */
+#define ZEN_KERNEL_ITER(set, TFloat) \
+	[](const Batch &batch) { \
+		Impl::IterateBatchScalar<TFloat>(batch, [](const auto &c, auto &z, const size_t first_iter, const size_t max_iter, const TFloat tolerance) { \
+			return Fractals::set::Iter(c, z, first_iter, max_iter, tolerance); \
+		}); \
+	}
+
+/**
+ * @brief Generic kernel of a CREATE_SET_BY_EXPR set, running its IterN on native width packs.
+ */
+#define ZEN_KERNEL_ITER_N(set, TFloat) \
+	[](const Batch &batch) { \
+		constexpr auto lanes = ZEN_SIMD_BYTES / sizeof(TFloat); \
+		Impl::IterateBatch<TFloat, lanes>(batch, [](const auto &c, auto &z, auto &count, const size_t max_iter, const TFloat tolerance) { \
+			Fractals::set::IterN(c, z, count, max_iter, tolerance); \
+		}); \
+	}
+
+}
+}
@@ -0,0 +1,262 @@
+#include "Perturbation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include <gmpxx.h>
+
+namespace Zen::Perturbation
+{
+
+auto ComputeReference(const Anchor &anchor, const Vec2l &pixel, const double zoom, const size_t maxIterations, const std::function<bool()> &isCancelled)
+	-> std::shared_ptr<const Reference>
+{
+	const auto bits = BitsForZoom(zoom);
+	const auto point = anchor.Moved(pixel, zoom);
+	const ComplexMpf c(point.Real(), point.Imag(), bits);
+	auto z = c;
+
+	auto reference = std::make_shared<Reference>();
+	reference->anchor = anchor;
+	reference->pixel = pixel;
+	reference->zoom = zoom;
+	reference->maxIterations = maxIterations;
+	reference->real.reserve(maxIterations + 1);
+	reference->imag.reserve(maxIterations + 1);
+
+	for (size_t i = 0; i <= maxIterations; ++i)
+	{
+		const auto value = z.ToComplex64();
+		reference->real.push_back(value.real);
+		reference->imag.push_back(value.imag);
+
+		if (AbsSq(value) > 4.0)
+		{
+			break;
+		}
+
+		if (i % 1024 == 0 && isCancelled())
+		{
+			return nullptr;
+		}
+
+		z.Square();
+		z.Add(c);
+	}
+
+	return reference;
+}
+
+auto ComputeSeries(const Reference &reference, const double radius) -> Series
+{
+	// how large the dc^3 term may get, in pixels, so the terms left out don't change any count
+	constexpr double Tolerance = 1.0 / 1048576.0;
+
+	const auto radiusSq = radius * radius;
+	const auto radiusCb = radiusSq * radius;
+
+	// the delta loop needs at least one iteration of the orbit left
+	const auto last = std::min(reference.real.size() - 1, reference.maxIterations);
+
+	Series series;
+	for (size_t n = 0; n + 1 < last; ++n)
+	{
+		// d' = 2 * Z * d + d * d + dc, per power of dc
+		const auto twoZ = Complex64(reference.real[n], reference.imag[n]) * 2.0;
+		const auto a = twoZ * series.a + Complex64(1.0, 0.0);
+		const auto b = twoZ * series.b + series.a * series.a;
+		const auto c = twoZ * series.c + series.a * series.b * 2.0;
+
+		const auto absA = Abs(a);
+		const auto absB = Abs(b);
+		const auto absC = Abs(c);
+		if (!std::isfinite(absC) || absC * radiusCb > Tolerance * absA / reference.zoom)
+		{
+			break;
+		}
+
+		// no pixel may escape within the skipped iterations
+		const auto absZ = Abs(Complex64(reference.real[n + 1], reference.imag[n + 1]));
+		if (absZ + absA * radius + absB * radiusSq + absC * radiusCb > 2.0)
+		{
+			break;
+		}
+
+		series.skipped = n + 1;
+		series.a = a;
+		series.b = b;
+		series.c = c;
+	}
+
+	return series;
+}
+
+/**
+ * @brief One run followed by the next, valid while the first stays valid and takes d below the radius of the second
+ */
+static auto Merge(const Bla &first, const Bla &second, const double radius) -> Bla
+{
+	const auto secondRadius = std::max(0.0, (second.radius - Abs(first.b) * radius) / Abs(first.a));
+	return { second.a * first.a, second.a * first.b + second.b, std::min(first.radius, secondRadius) };
+}
+
+auto ComputeBlaTable(const Reference &reference, const double radius) -> BlaTable
+{
+	// how large d may get relative to Z, so d * d stays below the rounding of 2 * Z * d in double precision
+	constexpr double Tolerance = 1.0 / (1ull << 53);
+
+	const auto single = [&](const size_t i) -> Bla {
+		// d' = a * d + b * dc with a = 2 * Z and b = 1, dc adds to the error like d does
+		const Complex64 z = { reference.real[i], reference.imag[i] };
+		const auto absZ = Abs(z);
+		return { z * 2.0, { 1.0, 0.0 }, std::max(0.0, (Tolerance * absZ - radius) / (2.0 * absZ + 1.0)) };
+	};
+
+	// the delta loop needs at least one iteration of the orbit left
+	const auto steps = std::min(reference.real.size() - 1, reference.maxIterations);
+
+	BlaTable table;
+	auto &pairs = table.levels.emplace_back(steps / 2);
+	for (size_t j = 0; j < pairs.size(); ++j)
+	{
+		pairs[j] = Merge(single(2 * j), single(2 * j + 1), radius);
+	}
+
+	while (table.levels.back().size() >= 2)
+	{
+		const auto below = table.levels.size() - 1;
+		auto &level = table.levels.emplace_back(table.levels[below].size() / 2);
+		for (size_t j = 0; j < level.size(); ++j)
+		{
+			level[j] = Merge(table.levels[below][2 * j], table.levels[below][2 * j + 1], radius);
+		}
+	}
+
+	return table;
+}
+
+/**
+ * @brief Find the longest run starting at iteration i that is valid for d and ends before end
+ * @return The run, nullptr if there is none
+ */
+static auto FindBla(const BlaTable &table, const size_t i, const double dAbsSq, const size_t end, size_t &length) -> const Bla *
+{
+	// runs only start at multiples of their length
+	const auto top = std::min<size_t>(std::countr_zero(i), table.levels.size());
+	for (auto level = top; level-- > 0;)
+	{
+		const auto runLength = (size_t)2 << level;
+		const auto index = i / runLength;
+		if (i + runLength > end || index >= table.levels[level].size())
+		{
+			continue;
+		}
+
+		const auto &bla = table.levels[level][index];
+		if (dAbsSq < bla.radius * bla.radius)
+		{
+			length = runLength;
+			return &bla;
+		}
+	}
+
+	return nullptr;
+}
+
+void IterateBatch(const Context &context, const Kernels::Batch &batch)
+{
+	// Pauldelbrot's criterion: once |z| drops below this fraction of |Z|, d has cancelled out most of Z
+	// and the precision d lacks starts to matter
+	constexpr double GlitchTolerance = 1e-3;
+
+	const auto &reference = *context.reference;
+	const auto &series = context.series;
+	const auto orbitReal = reference.real.data();
+	const auto orbitImag = reference.imag.data();
+	const auto orbitEnd = reference.real.size() - 1;
+
+	for (size_t point = 0; point < batch.count; ++point)
+	{
+		const auto dcReal = batch.real[point];
+		const auto dcImag = batch.imag[point];
+
+		// continuing would need the delta, which isn't kept, so every point starts over, after the series
+		const Complex64 dc = { dcReal, dcImag };
+		const auto dcSq = dc * dc;
+		const auto d = series.a * dc + series.b * dcSq + series.c * dcSq * dc;
+		auto dReal = d.real;
+		auto dImag = d.imag;
+		auto i = series.skipped;
+		auto escaped = false;
+		auto glitched = false;
+
+		const auto end = std::min(batch.maxIter, orbitEnd);
+		while (i < end)
+		{
+			auto next = i + 1;
+			size_t length = 0;
+			const auto bla = context.bla ? FindBla(*context.bla, i, dReal * dReal + dImag * dImag, end, length) : nullptr;
+			if (bla)
+			{
+				// d' = a * d + b * dc, for the whole run
+				const auto jumped = bla->a * Complex64(dReal, dImag) + bla->b * dc;
+				dReal = jumped.real;
+				dImag = jumped.imag;
+				next = i + length;
+			}
+			else
+			{
+				// d' = 2 * Z * d + d * d + dc
+				const auto zr = orbitReal[i];
+				const auto zi = orbitImag[i];
+				const auto nextReal = 2.0 * (zr * dReal - zi * dImag) + (dReal * dReal - dImag * dImag) + dcReal;
+				const auto nextImag = 2.0 * (zr * dImag + zi * dReal) + 2.0 * dReal * dImag + dcImag;
+				dReal = nextReal;
+				dImag = nextImag;
+			}
+
+			const auto referenceReal = orbitReal[next];
+			const auto referenceImag = orbitImag[next];
+			const auto real = referenceReal + dReal;
+			const auto imag = referenceImag + dImag;
+			const auto absSq = real * real + imag * imag;
+			if (absSq > 4.0)
+			{
+				batch.zReal[point] = real;
+				batch.zImag[point] = imag;
+				escaped = true;
+				i = next - 1;
+				break;
+			}
+
+			if (absSq < GlitchTolerance * GlitchTolerance * (referenceReal * referenceReal + referenceImag * referenceImag))
+			{
+				glitched = true;
+				break;
+			}
+
+			i = next;
+		}
+
+		// a point still going when the orbit of the reference ends needs another reference as well
+		if (glitched || (!escaped && i < batch.maxIter))
+		{
+			batch.zReal[point] = std::numeric_limits<double>::quiet_NaN();
+			batch.zImag[point] = std::numeric_limits<double>::quiet_NaN();
+			batch.iterations[point] = Glitched;
+			continue;
+		}
+
+		if (!escaped)
+		{
+			batch.zReal[point] = std::numeric_limits<double>::quiet_NaN();
+			batch.zImag[point] = std::numeric_limits<double>::quiet_NaN();
+		}
+
+		batch.iterations[point] = i;
+	}
+}
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Anchor.hpp"
+#include "Complex.hpp"
+#include "Kernels.hpp"
+#include "Vec2.hpp"
+
+namespace Zen::Perturbation
+{
+
+/**
+ * @brief Orbit of a single reference point of the Mandelbrot set, iterated in arbitrary precision
+ * and stored rounded to double. Every other point is iterated as a small delta from it:
+ * with z = Z + d and c = C + dc, z * z + c turns into d' = 2 * Z * d + d * d + dc,
+ * which only needs double precision however deep the zoom is.
+ */
+struct Reference
+{
+	Anchor anchor;        // the point pixel is counted from
+	Vec2l pixel;          // the reference point, counted like RenderSettings::origin
+	double zoom;
+	size_t maxIterations; // the limit the orbit was computed for
+
+	// Z after 0, 1, 2... iterations (Z = C after 0), up to and including the iteration it escaped at
+	std::vector<double> real;
+	std::vector<double> imag;
+};
+
+/**
+ * @brief Truncated power series of the delta in dc, shared by every pixel of a view:
+ * after skipped iterations, d = a * dc + b * dc^2 + c * dc^3.
+ * Deep in a zoom, the first thousands of iterations look alike for the whole view, and are skipped this way.
+ */
+struct Series
+{
+	size_t skipped = 0;
+	Complex64 a = { 1.0, 0.0 }; // d = dc without skipping
+	Complex64 b, c;
+};
+
+/**
+ * @brief Bilinear approximation of a run of iterations: while |d| < radius, the d * d terms
+ * are too small to matter and the run turns into d' = a * d + b * dc.
+ */
+struct Bla
+{
+	Complex64 a, b;
+	double radius;
+};
+
+/**
+ * @brief Bilinear approximations of the whole reference orbit.
+ * levels[k][j] covers the 2^(k+1) iterations starting at j * 2^(k+1), each level merges pairs of the one below.
+ * Single iterations are left out, those are no faster than iterating.
+ * Unlike the series, a pixel can jump ahead with it anywhere along the orbit.
+ */
+struct BlaTable
+{
+	std::vector<std::vector<Bla>> levels;
+};
+
+/**
+ * @brief Everything the delta loop needs besides the pixels
+ */
+struct Context
+{
+	const Reference *reference;
+	Series series;
+	const BlaTable *bla; // step by step if nullptr
+};
+
+/**
+ * @brief Compute the orbit of pixel at zoom, counted from anchor, in as many bits as the zoom needs.
+ * @return nullptr if isCancelled returned true in between
+ */
+auto ComputeReference(const Anchor &anchor, const Vec2l &pixel, const double zoom, const size_t maxIterations, const std::function<bool()> &isCancelled)
+	-> std::shared_ptr<const Reference>;
+
+/**
+ * @brief Find how many iterations the series can skip for every dc up to radius from the reference.
+ * It stops at the first iteration where the dc^3 term could throw the delta off by more than a fraction
+ * of the distance between two neighbouring pixels (1 / zoom apart), or where a pixel might escape.
+ */
+auto ComputeSeries(const Reference &reference, const double radius) -> Series;
+
+/**
+ * @brief Build the bilinear approximations of the reference, for every dc up to radius from it
+ */
+auto ComputeBlaTable(const Reference &reference, const double radius) -> BlaTable;
+
+/**
+ * @brief Iteration count of points the reference can't be used for, see IterateBatch
+ */
+constexpr size_t Glitched = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Iterate a batch like a Mandelbrot kernel, except that real and imag are the offsets of the points
+ * from the reference (dc) instead of c. z is still the full value, but points that hit the limit get NaN,
+ * as continuing them would need the delta. Every point starts after the iterations skipped by the series,
+ * and jumps ahead with the bilinear approximations wherever they are valid, if there are any.
+ * Points whose delta lost too much precision, or that are not done when the orbit of the reference ends,
+ * get Glitched as count, they have to be iterated again with another reference.
+ */
+void IterateBatch(const Context &context, const Kernels::Batch &batch);
+
+}
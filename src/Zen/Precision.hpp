@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+namespace Zen
+{
+
+/**
+ * @brief Floating point types the fractal kernels can run in, ordered from fastest to most precise.
+ * Double-double is the last one, __float128 (Complex128) is slower and barely more precise,
+ * deeper zooms take perturbation instead.
+ */
+enum Precision : int
+{
+	Precision_Float32,
+	Precision_Float64,
+	Precision_DoubleDouble, // see DoubleDouble.hpp
+	Precision_Count
+};
+
+constexpr std::array<const char *, Precision_Count> PrecisionNames = {
+	"Float32",
+	"Float64",
+	"Double-double"
+};
+
+constexpr std::array<double, Precision_Count> PrecisionEpsilon = {
+	std::numeric_limits<float>::epsilon(),
+	std::numeric_limits<double>::epsilon(),
+	std::numeric_limits<double>::epsilon() * std::numeric_limits<double>::epsilon() // 2^-104, one bit less than the mantissa
+};
+
+/**
+ * @brief Safety factor kept between the rounding error of a coordinate and the pixel size,
+ * since the error grows while iterating.
+ */
+constexpr auto PrecisionHeadroom = 512.0;
+
+/**
+ * @brief Check if precision can still tell neighbouring pixels apart.
+ * @param pixelSize The distance between two pixels in world space (1 / zoom)
+ * @param magnitude The largest absolute coordinate visible in the view
+ */
+constexpr auto CanResolve(const Precision precision, const double pixelSize, const double magnitude) -> bool
+{
+	// coordinates below 2 still have to resolve the escape radius
+	const auto scale = magnitude > 2.0 ? magnitude : 2.0;
+	return PrecisionEpsilon[precision] * scale * PrecisionHeadroom < pixelSize;
+}
+
+/**
+ * @brief Select the fastest precision which can still tell neighbouring pixels apart,
+ * the most precise one if none can (check with CanResolve).
+ * @param pixelSize The distance between two pixels in world space (1 / zoom)
+ * @param magnitude The largest absolute coordinate visible in the view
+ */
+constexpr auto SelectPrecision(const double pixelSize, const double magnitude) -> Precision
+{
+	for (int precision = 0; precision < Precision_Count - 1; ++precision)
+	{
+		if (CanResolve((Precision)precision, pixelSize, magnitude))
+		{
+			return (Precision)precision;
+		}
+	}
+
+	return (Precision)(Precision_Count - 1);
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+
+namespace Zen
+{
+
+/**
+ * @brief How the renderer decides which pixels of a tile to iterate.
+ */
+enum RenderAlgorithm : int
+{
+	RenderAlgorithm_BruteForce,      // every pixel
+	RenderAlgorithm_MarianiSilver,   // rectangle borders, filling rectangles whose border has a single count
+	RenderAlgorithm_BoundaryTracing, // edges between counts, filling the regions they enclose
+	RenderAlgorithm_Count
+};
+
+constexpr std::array<const char *, RenderAlgorithm_Count> RenderAlgorithmNames = {
+	"Brute force",
+	"Mariani-Silver",
+	"Boundary tracing"
+};
+
+/**
+ * @brief How the renderer iterates a single pixel.
+ */
+enum RenderEngine : int
+{
+	RenderEngine_Direct,       // the kernel of the fractal, on c in the selected precision
+	RenderEngine_Perturbation, // deltas from an arbitrary precision reference orbit, Mandelbrot only
+	RenderEngine_Bla,          // perturbation, jumping ahead with bilinear approximations
+	RenderEngine_Count
+};
+
+constexpr std::array<const char *, RenderEngine_Count> RenderEngineNames = {
+	"Direct",
+	"Perturbation",
+	"Perturbation + BLA"
+};
+
+}
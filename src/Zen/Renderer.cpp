@@ -0,0 +1,1268 @@
+#include "Renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "DoubleDouble.hpp"
+#include "Grid.hpp"
+#include "Hash.hpp"
+
+namespace Zen
+{
+
+auto Fingerprint(const RenderSettings &settings) -> size_t
+{
+	auto hash = HashSeed;
+
+	// field by field, padding bytes are indeterminate
+	hash = HashValue(hash, settings.fractal);
+	hash = HashValue(hash, settings.precision);
+	hash = HashValue(hash, settings.maxIterations);
+	hash = HashValue(hash, settings.kernels);
+	hash = HashValue(hash, settings.engine);
+	hash = HashValue(hash, settings.algorithm);
+	hash = HashValue(hash, settings.periodicity);
+	hash = HashValue(hash, settings.anchor.Hash());
+	hash = HashValue(hash, settings.origin.x);
+	hash = HashValue(hash, settings.origin.y);
+	hash = HashValue(hash, settings.zoom);
+	hash = HashValue(hash, settings.width);
+	hash = HashValue(hash, settings.height);
+
+	return hash;
+}
+
+/**
+ * @brief Continuous escape iteration, from the value of z right after escaping.
+ * Each iteration raises |z| to the degree of the set, so log(log|z|) / log(degree) counts the iterations past the bailout.
+ */
+static auto SmoothIterations(const size_t iterations, const double real, const double imag, const int degree) -> float
+{
+	const auto absSq = real * real + imag * imag;
+	if (absSq <= 4.0 || !std::isfinite(absSq))
+	{
+		return (float)iterations;
+	}
+
+	const auto logAbs = 0.5 * std::log(absSq);
+	return (float)(iterations + 1 - std::log(logAbs / std::log(2.0)) / std::log((double)degree));
+}
+
+/**
+ * @brief Division rounding towards negative infinity
+ */
+static auto FloorDiv(const int64_t a, const int64_t b) -> int64_t
+{
+	return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+void IterationBuffer::Resize(const int width, const int height)
+{
+	this->width = width;
+	this->height = height;
+
+	iterations.assign(width * height, 0);
+	smooth.assign(width * height, 0.0f);
+	zReal.assign(width * height, 0.0);
+	zImag.assign(width * height, 0.0);
+	limits.assign(width * height, 0);
+}
+
+void IterationBuffer::Shift(const int dx, const int dy)
+{
+	ShiftGrid(iterations, width, height, dx, dy, (size_t)0);
+	ShiftGrid(smooth, width, height, dx, dy, 0.0f);
+	ShiftGrid(zReal, width, height, dx, dy, 0.0);
+	ShiftGrid(zImag, width, height, dx, dy, 0.0);
+	ShiftGrid(limits, width, height, dx, dy, (size_t)0);
+}
+
+void IterationBuffer::Reproject(const Vec2l &fromOrigin, const double fromZoom, const Vec2l &toOrigin, const double toZoom)
+{
+	const auto previousIterations = iterations;
+	const auto previousSmooth = smooth;
+	const auto scale = fromZoom / toZoom;
+
+	// pixel p of the new view is at (toOrigin + p) / toZoom, which is pixel (toOrigin + p) * fromZoom / toZoom - fromOrigin of the old one
+	std::vector<int> columns(width);
+	for (int x = 0; x < width; ++x)
+	{
+		columns[x] = (int)std::floor((toOrigin.x + x) * scale - fromOrigin.x + 0.5);
+	}
+
+	for (int y = 0; y < height; ++y)
+	{
+		const auto fromY = (int)std::floor((toOrigin.y + y) * scale - fromOrigin.y + 0.5);
+
+		for (int x = 0; x < width; ++x)
+		{
+			const auto index = y * width + x;
+			const auto fromX = columns[x];
+
+			if (fromX >= 0 && fromX < width && fromY >= 0 && fromY < height)
+			{
+				iterations[index] = previousIterations[fromY * width + fromX];
+				smooth[index] = previousSmooth[fromY * width + fromX];
+			}
+			else
+			{
+				iterations[index] = 0;
+				smooth[index] = 0.0f;
+			}
+		}
+	}
+
+	std::fill(limits.begin(), limits.end(), 0);
+}
+
+/**
+ * @brief Working copy of a tile while it is rendered, rows are TileSize apart
+ */
+struct TileWork
+{
+	static constexpr auto Size = Renderer::TileSize;
+	static constexpr auto Pixels = Size * Size;
+
+	const RenderSettings &settings;
+	const SDL_Rect tile;
+	const Kernels::IterateFn iterate;
+	const Perturbation::Context *perturbation; // iterate deltas from a reference instead, if set
+
+	std::array<size_t, Pixels> iterations, limits;
+	std::array<float, Pixels> smooth;
+	std::array<double, Pixels> zReal, zImag;
+	std::array<bool, Pixels> done; // has a result for the current iteration limit
+
+	size_t iterated = 0, resumed = 0, filled = 0;
+
+	TileWork(const RenderSettings &settings, const SDL_Rect &tile, const Kernels::IterateFn iterate, const Perturbation::Context *perturbation)
+		: settings(settings)
+		, tile(tile)
+		, iterate(iterate)
+		, perturbation(perturbation)
+	{
+	}
+
+	auto CanIterate() const -> bool { return iterate || perturbation; }
+
+	/**
+	 * @brief The limit a pixel is stored with, glitched pixels get Glitched instead, they wait for a correction pass
+	 */
+	auto LimitOf(const int pixel) const -> size_t
+	{
+		return iterations[pixel] == Perturbation::Glitched ? Perturbation::Glitched : settings.maxIterations;
+	}
+
+	/**
+	 * @brief Count the pixels of the tile that have no result yet
+	 */
+	auto CountPending() const -> size_t
+	{
+		size_t count = 0;
+		for (int y = 0; y < tile.h; ++y)
+		{
+			count += std::count(&done[y * Size], &done[y * Size] + tile.w, false);
+		}
+		return count;
+	}
+
+	auto HasGlitches() const -> bool
+	{
+		for (int y = 0; y < tile.h; ++y)
+		{
+			for (int x = 0; x < tile.w; ++x)
+			{
+				if (iterations[y * Size + x] == Perturbation::Glitched)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Copy the tile out of buffer. Glitched pixels only count as not done for a correction pass,
+	 * the regular passes would run into the same glitch again.
+	 */
+	void Load(const IterationBuffer &buffer, const bool correction)
+	{
+		const auto maxIterations = settings.maxIterations;
+
+		for (int y = 0; y < tile.h; ++y)
+		{
+			const auto index = (tile.y + y) * buffer.width + tile.x;
+			std::copy_n(&buffer.iterations[index], tile.w, &iterations[y * Size]);
+			std::copy_n(&buffer.smooth[index], tile.w, &smooth[y * Size]);
+			std::copy_n(&buffer.zReal[index], tile.w, &zReal[y * Size]);
+			std::copy_n(&buffer.zImag[index], tile.w, &zImag[y * Size]);
+			std::copy_n(&buffer.limits[index], tile.w, &limits[y * Size]);
+
+			for (int x = 0; x < tile.w; ++x)
+			{
+				// computed with this limit, or escaped below both limits, so nothing changes
+				const auto pixel = y * Size + x;
+				const auto limit = limits[pixel];
+				done[pixel] = limit == Perturbation::Glitched
+					? !correction
+					: limit != 0 && (limit == maxIterations || iterations[pixel] < std::min(limit, maxIterations));
+			}
+		}
+	}
+
+	void Store(IterationBuffer &buffer) const
+	{
+		for (int y = 0; y < tile.h; ++y)
+		{
+			const auto index = (tile.y + y) * buffer.width + tile.x;
+			std::copy_n(&iterations[y * Size], tile.w, &buffer.iterations[index]);
+			std::copy_n(&smooth[y * Size], tile.w, &buffer.smooth[index]);
+			std::copy_n(&zReal[y * Size], tile.w, &buffer.zReal[index]);
+			std::copy_n(&zImag[y * Size], tile.w, &buffer.zImag[index]);
+			for (int x = 0; x < tile.w; ++x)
+			{
+				buffer.limits[index + x] = LimitOf(y * Size + x);
+			}
+		}
+	}
+
+	/**
+	 * @brief Store the pixels done so far. Pixels without any result show the sample at the top left
+	 * of their step x step block instead, the others keep what they had.
+	 */
+	void StorePreview(IterationBuffer &buffer, const int step) const
+	{
+		for (int y = 0; y < tile.h; ++y)
+		{
+			for (int x = 0; x < tile.w; ++x)
+			{
+				const auto pixel = y * Size + x;
+				const auto index = (tile.y + y) * buffer.width + tile.x + x;
+
+				if (done[pixel])
+				{
+					buffer.iterations[index] = iterations[pixel];
+					buffer.smooth[index] = smooth[pixel];
+					buffer.zReal[index] = zReal[pixel];
+					buffer.zImag[index] = zImag[pixel];
+					buffer.limits[index] = LimitOf(pixel);
+				}
+				else if (limits[pixel] == 0)
+				{
+					const auto sample = (y - y % step) * Size + x - x % step;
+					buffer.iterations[index] = iterations[sample];
+					buffer.smooth[index] = smooth[sample];
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Iterate the given pixels (indices into the tile) that are not done yet, in batches
+	 */
+	void Iterate(const int *pixels, const size_t count)
+	{
+		const auto maxIterations = settings.maxIterations;
+		const auto tolerance = settings.periodicity ? Renderer::PeriodicityTolerance / settings.zoom : 0.0;
+
+		// c needs low parts, and z (kept in double) is too coarse to continue from
+		const auto beyondDouble = !perturbation && PrecisionEpsilon[settings.precision] < std::numeric_limits<double>::epsilon();
+		const auto anchorReal = settings.anchor.RealDoubleDouble().hi;
+		const auto anchorImag = settings.anchor.ImagDoubleDouble().hi;
+
+		std::array<double, Size> real, imag, realLo, imagLo, batchZReal, batchZImag;
+		std::array<size_t, Size> batchIterations;
+		std::array<int, Size> batchPixels;
+
+		for (size_t first = 0; first < count; first += Size)
+		{
+			size_t batchCount = 0;
+
+			for (size_t i = first; i < std::min(first + Size, count); ++i)
+			{
+				const auto pixel = pixels[i];
+				if (done[pixel])
+				{
+					continue;
+				}
+
+				const auto limit = limits[pixel];
+				if (perturbation)
+				{
+					// offset from the reference, the pixel difference is exact whatever the zoom
+					const auto &reference = *perturbation->reference;
+					real[batchCount] = (double)(settings.origin.x + tile.x + pixel % Size - reference.pixel.x) / settings.zoom;
+					imag[batchCount] = (double)(settings.origin.y + tile.y + pixel / Size - reference.pixel.y) / settings.zoom;
+				}
+				else if (beyondDouble)
+				{
+					const auto cReal = settings.anchor.RealDoubleDouble() + DoubleDouble::FromInteger(settings.origin.x + tile.x + pixel % Size) / settings.zoom;
+					const auto cImag = settings.anchor.ImagDoubleDouble() + DoubleDouble::FromInteger(settings.origin.y + tile.y + pixel / Size) / settings.zoom;
+					real[batchCount] = cReal.hi;
+					imag[batchCount] = cImag.hi;
+					realLo[batchCount] = cReal.lo;
+					imagLo[batchCount] = cImag.lo;
+				}
+				else
+				{
+					real[batchCount] = anchorReal + (settings.origin.x + tile.x + pixel % Size) / settings.zoom;
+					imag[batchCount] = anchorImag + (settings.origin.y + tile.y + pixel / Size) / settings.zoom;
+				}
+
+				// z of filled pixels is unknown (NaN), those start over
+				if (limit != 0 && limit < maxIterations && !std::isnan(zReal[pixel]) && !beyondDouble)
+				{
+					// hit the old limit, continue where it stopped
+					batchZReal[batchCount] = zReal[pixel];
+					batchZImag[batchCount] = zImag[pixel];
+					batchIterations[batchCount] = iterations[pixel];
+					resumed++;
+				}
+				else
+				{
+					// new, or the limit was lowered and z at the new limit is unknown
+					batchZReal[batchCount] = real[batchCount];
+					batchZImag[batchCount] = imag[batchCount];
+					batchIterations[batchCount] = 0;
+					iterated++;
+				}
+
+				batchPixels[batchCount++] = pixel;
+			}
+
+			const Kernels::Batch batch = {
+				real.data(),
+				imag.data(),
+				batchZReal.data(),
+				batchZImag.data(),
+				batchIterations.data(),
+				batchCount,
+				maxIterations,
+				tolerance,
+				beyondDouble ? realLo.data() : nullptr,
+				beyondDouble ? imagLo.data() : nullptr
+			};
+			if (batchCount > 0 && perturbation)
+			{
+				Perturbation::IterateBatch(*perturbation, batch);
+			}
+			else if (batchCount > 0 && iterate)
+			{
+				iterate(batch);
+			}
+
+			for (size_t i = 0; i < batchCount; ++i)
+			{
+				const auto pixel = batchPixels[i];
+				iterations[pixel] = batchIterations[i];
+				zReal[pixel] = batchZReal[i];
+				zImag[pixel] = batchZImag[i];
+				smooth[pixel] = SmoothIterations(batchIterations[i], batchZReal[i], batchZImag[i], FractalDegrees[settings.fractal]);
+				done[pixel] = true;
+			}
+		}
+	}
+
+	/**
+	 * @brief Give a pixel a count without iterating it, unless it is done already
+	 */
+	void Fill(const int pixel, const size_t count)
+	{
+		if (done[pixel])
+		{
+			return;
+		}
+
+		iterations[pixel] = count;
+		smooth[pixel] = (float)count;
+		zReal[pixel] = std::numeric_limits<double>::quiet_NaN();
+		zImag[pixel] = std::numeric_limits<double>::quiet_NaN();
+		done[pixel] = true;
+		filled++;
+	}
+};
+
+/**
+ * @brief Iterate every step-th pixel of every step-th row
+ */
+template<typename TCancelled>
+static void RenderSamples(TileWork &work, const int step, const TCancelled &isCancelled)
+{
+	std::array<int, TileWork::Size> row;
+
+	for (int y = 0; y < work.tile.h; y += step)
+	{
+		if (isCancelled())
+		{
+			return;
+		}
+
+		size_t count = 0;
+		for (int x = 0; x < work.tile.w; x += step)
+		{
+			row[count++] = y * TileWork::Size + x;
+		}
+		work.Iterate(row.data(), count);
+	}
+}
+
+/**
+ * @brief Iterate every pixel, row by row
+ */
+template<typename TCancelled>
+static void RenderBruteForce(TileWork &work, const TCancelled &isCancelled)
+{
+	std::array<int, TileWork::Size> row;
+
+	for (int y = 0; y < work.tile.h; ++y)
+	{
+		if (isCancelled())
+		{
+			return;
+		}
+
+		for (int x = 0; x < work.tile.w; ++x)
+		{
+			row[x] = y * TileWork::Size + x;
+		}
+		work.Iterate(row.data(), work.tile.w);
+	}
+}
+
+/**
+ * @brief Mariani-Silver subdivision: iterate the border of a rectangle, if the whole border has the same count
+ * fill the inside with it, otherwise split the rectangle in two (sharing the middle line) and repeat.
+ */
+template<typename TCancelled>
+static void RenderMarianiSilver(TileWork &work, const TCancelled &isCancelled)
+{
+	// below this, iterating the inside is cheaper than splitting further
+	constexpr int MinSize = 4;
+
+	std::array<int, 4 * TileWork::Size> border;
+
+	const auto subdivide = [&](const auto &self, const int left, const int top, const int width, const int height) -> void
+	{
+		if (isCancelled())
+		{
+			return;
+		}
+
+		const auto right = left + width - 1;
+		const auto bottom = top + height - 1;
+
+		size_t count = 0;
+		for (int x = left; x <= right; ++x)
+		{
+			border[count++] = top * TileWork::Size + x;
+			if (bottom != top)
+			{
+				border[count++] = bottom * TileWork::Size + x;
+			}
+		}
+		for (int y = top + 1; y < bottom; ++y)
+		{
+			border[count++] = y * TileWork::Size + left;
+			if (right != left)
+			{
+				border[count++] = y * TileWork::Size + right;
+			}
+		}
+		work.Iterate(border.data(), count);
+
+		if (width <= 2 || height <= 2)
+		{
+			return;
+		}
+
+		const auto first = work.iterations[border[0]];
+		const auto uniform = std::all_of(border.begin(), border.begin() + count, [&](const int pixel) { return work.iterations[pixel] == first; });
+
+		if (uniform)
+		{
+			for (int y = top + 1; y < bottom; ++y)
+			{
+				for (int x = left + 1; x < right; ++x)
+				{
+					work.Fill(y * TileWork::Size + x, first);
+				}
+			}
+			return;
+		}
+
+		if (width <= MinSize || height <= MinSize)
+		{
+			// border is iterated already, reuse it for the rows of the inside
+			for (int y = top + 1; y < bottom; ++y)
+			{
+				for (int x = left + 1; x < right; ++x)
+				{
+					border[x - left - 1] = y * TileWork::Size + x;
+				}
+				work.Iterate(border.data(), width - 2);
+			}
+			return;
+		}
+
+		if (width >= height)
+		{
+			const auto half = width / 2;
+			self(self, left, top, half + 1, height);
+			self(self, left + half, top, width - half, height);
+		}
+		else
+		{
+			const auto half = height / 2;
+			self(self, left, top, width, half + 1);
+			self(self, left, top + half, width, height - half);
+		}
+	};
+
+	subdivide(subdivide, 0, 0, work.tile.w, work.tile.h);
+}
+
+/**
+ * @brief Boundary tracing: starting from the tile border, follow the edges between pixels of different counts,
+ * iterating only the pixels along them, then fill the regions they enclose from the left.
+ * Which pixels get traced doesn't depend on the order, so pixels are traced in waves that are iterated as one batch.
+ */
+template<typename TCancelled>
+static void RenderBoundaryTracing(TileWork &work, const TCancelled &isCancelled)
+{
+	constexpr auto Size = TileWork::Size;
+	const auto width = work.tile.w;
+	const auto height = work.tile.h;
+
+	std::array<bool, TileWork::Pixels> queued {};
+	std::vector<int> queue;
+
+	const auto push = [&](const int x, const int y)
+	{
+		const auto pixel = y * Size + x;
+		if (!queued[pixel])
+		{
+			queued[pixel] = true;
+			queue.push_back(pixel);
+		}
+	};
+
+	for (int x = 0; x < width; ++x)
+	{
+		push(x, 0);
+		push(x, height - 1);
+	}
+	for (int y = 1; y < height - 1; ++y)
+	{
+		push(0, y);
+		push(width - 1, y);
+	}
+
+	std::array<int, Size> wave;
+	std::array<int, 5 * Size> needed;
+	size_t neededCount = 0;
+
+	// neighbouring wave pixels share neighbours, each goes into the batch once
+	std::array<int, TileWork::Pixels> neededBy {}; // the last wave that needed the pixel, counted from 1
+	int waveNumber = 0;
+
+	const auto need = [&](const int pixel)
+	{
+		if (neededBy[pixel] != waveNumber && !work.done[pixel])
+		{
+			neededBy[pixel] = waveNumber;
+			needed[neededCount++] = pixel;
+		}
+	};
+
+	while (!queue.empty())
+	{
+		if (isCancelled())
+		{
+			return;
+		}
+
+		const auto waveSize = std::min(queue.size(), (size_t)Size);
+		std::copy(queue.end() - waveSize, queue.end(), wave.begin());
+		queue.resize(queue.size() - waveSize);
+
+		// the wave and its neighbours
+		neededCount = 0;
+		waveNumber++;
+		for (size_t i = 0; i < waveSize; ++i)
+		{
+			const auto pixel = wave[i];
+			const auto x = pixel % Size;
+			const auto y = pixel / Size;
+
+			need(pixel);
+			if (x > 0)
+			{
+				need(pixel - 1);
+			}
+			if (x < width - 1)
+			{
+				need(pixel + 1);
+			}
+			if (y > 0)
+			{
+				need(pixel - Size);
+			}
+			if (y < height - 1)
+			{
+				need(pixel + Size);
+			}
+		}
+		work.Iterate(needed.data(), neededCount);
+
+		// a neighbour with another count is on the edge as well
+		for (size_t i = 0; i < waveSize; ++i)
+		{
+			const auto pixel = wave[i];
+			const auto x = pixel % Size;
+			const auto y = pixel / Size;
+			const auto center = work.iterations[pixel];
+
+			const auto left = x > 0 && work.iterations[pixel - 1] != center;
+			const auto right = x < width - 1 && work.iterations[pixel + 1] != center;
+			const auto up = y > 0 && work.iterations[pixel - Size] != center;
+			const auto down = y < height - 1 && work.iterations[pixel + Size] != center;
+
+			if (left)
+			{
+				push(x - 1, y);
+			}
+			if (right)
+			{
+				push(x + 1, y);
+			}
+			if (up)
+			{
+				push(x, y - 1);
+			}
+			if (down)
+			{
+				push(x, y + 1);
+			}
+
+			// diagonals, so edges running at an angle are followed too
+			if (x > 0 && y > 0 && (left || up))
+			{
+				push(x - 1, y - 1);
+			}
+			if (x < width - 1 && y > 0 && (right || up))
+			{
+				push(x + 1, y - 1);
+			}
+			if (x > 0 && y < height - 1 && (left || down))
+			{
+				push(x - 1, y + 1);
+			}
+			if (x < width - 1 && y < height - 1 && (right || down))
+			{
+				push(x + 1, y + 1);
+			}
+		}
+	}
+
+	// everything not traced is enclosed by traced pixels of one count, and the first column is traced
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 1; x < width; ++x)
+		{
+			const auto pixel = y * Size + x;
+			work.Fill(pixel, work.iterations[pixel - 1]);
+		}
+	}
+}
+
+/**
+ * @brief Find the largest blob of glitched pixels (4-connected) and count all glitched pixels on the way
+ * @return Candidates for the next reference: the pixel of the blob closest to its centroid,
+ * then a few spread over the blob. Empty if there are no glitched pixels.
+ */
+static auto FindGlitch(const IterationBuffer &buffer, size_t &glitched) -> std::vector<Vec2>
+{
+	constexpr size_t Candidates = 4;
+
+	const auto isGlitched = [&](const int index) { return buffer.limits[index] == Perturbation::Glitched; };
+
+	std::vector<bool> visited(buffer.iterations.size(), false);
+	std::vector<int> blob, largest;
+	glitched = 0;
+
+	for (int start = 0; start < (int)buffer.iterations.size(); ++start)
+	{
+		if (visited[start] || !isGlitched(start))
+		{
+			continue;
+		}
+
+		// flood fill, blob doubles as the stack
+		blob.assign(1, start);
+		visited[start] = true;
+		for (size_t i = 0; i < blob.size(); ++i)
+		{
+			const auto x = blob[i] % buffer.width;
+			const auto y = blob[i] / buffer.width;
+			const std::array<std::pair<bool, int>, 4> neighbours = { {
+				{ x > 0, blob[i] - 1 },
+				{ x < buffer.width - 1, blob[i] + 1 },
+				{ y > 0, blob[i] - buffer.width },
+				{ y < buffer.height - 1, blob[i] + buffer.width }
+			} };
+
+			for (const auto &[inside, neighbour] : neighbours)
+			{
+				if (inside && !visited[neighbour] && isGlitched(neighbour))
+				{
+					visited[neighbour] = true;
+					blob.push_back(neighbour);
+				}
+			}
+		}
+
+		glitched += blob.size();
+		if (blob.size() > largest.size())
+		{
+			std::swap(blob, largest);
+		}
+	}
+
+	if (largest.empty())
+	{
+		return {};
+	}
+
+	double centerX = 0.0, centerY = 0.0;
+	for (const auto index : largest)
+	{
+		centerX += index % buffer.width;
+		centerY += index / buffer.width;
+	}
+	centerX /= largest.size();
+	centerY /= largest.size();
+
+	// the centroid itself can lie outside of a curved blob
+	const auto closest = *std::min_element(largest.begin(), largest.end(), [&](const int a, const int b) {
+		return std::hypot(a % buffer.width - centerX, a / buffer.width - centerY) < std::hypot(b % buffer.width - centerX, b / buffer.width - centerY);
+	});
+	std::vector<Vec2> candidates = { { closest % buffer.width, closest / buffer.width } };
+
+	// the flood fill went outwards from the first pixel, so these spread over the blob
+	for (size_t i = 1; i < Candidates && i < largest.size(); ++i)
+	{
+		const auto index = largest[i * largest.size() / Candidates];
+		candidates.push_back({ index % buffer.width, index / buffer.width });
+	}
+	return candidates;
+}
+
+Renderer::Renderer(ThreadPool &pool, TileCache &cache)
+	: pool(pool)
+	, cache(cache)
+{
+	thread = std::thread(&Renderer::ThreadLoop, this);
+}
+
+Renderer::~Renderer()
+{
+	{
+		std::lock_guard lock(jobMutex);
+		stopping = true;
+		generation++;
+	}
+	jobAvailable.notify_one();
+
+	thread.join();
+}
+
+void Renderer::Request(const RenderSettings &settings)
+{
+	const auto fingerprint = Fingerprint(settings);
+	if (requestedFingerprint == fingerprint)
+	{
+		return;
+	}
+	requestedFingerprint = fingerprint;
+
+	{
+		std::lock_guard lock(jobMutex);
+
+		// cancels the tiles of the job in flight
+		pending = Job { settings, ++generation };
+		busy = true;
+	}
+	jobAvailable.notify_one();
+}
+
+auto Renderer::IsIdle() -> bool
+{
+	// busy first, a job finishes its tiles before it clears busy
+	if (busy)
+	{
+		return false;
+	}
+
+	std::lock_guard lock(outputMutex);
+	return finishedTiles.empty();
+}
+
+void Renderer::Present(Canvas &canvas, const ColorSettings &colors)
+{
+	std::lock_guard lock(outputMutex);
+
+	if (canvas.width != buffer.width || canvas.height != buffer.height)
+	{
+		// a job for the new size is on its way
+		finishedTiles.clear();
+		presentShift = {};
+		return;
+	}
+
+	if (presentShift.x != 0 || presentShift.y != 0)
+	{
+		canvas.Shift(presentShift.x, presentShift.y);
+		presentShift = {};
+	}
+
+	const auto fingerprint = Fingerprint(colors);
+	if (presentedColors != fingerprint)
+	{
+		presentedColors = fingerprint;
+		finishedTiles = { SDL_Rect { 0, 0, buffer.width, buffer.height } };
+	}
+
+	for (const auto &tile : finishedTiles)
+	{
+		for (int y = tile.y; y < tile.y + tile.h; ++y)
+		{
+			for (int x = tile.x; x < tile.x + tile.w; ++x)
+			{
+				const auto index = y * buffer.width + x;
+				canvas.DrawPoint(x, y, Colorize(colors, buffer.iterations[index], buffer.smooth[index], buffer.maxIterations));
+			}
+		}
+	}
+
+	finishedTiles.clear();
+}
+
+void Renderer::ThreadLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock lock(jobMutex);
+			jobAvailable.wait(lock, [&] { return stopping || pending.has_value(); });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			job = std::move(*pending);
+			pending.reset();
+		}
+
+		RunJob(job);
+
+		std::lock_guard lock(jobMutex);
+		if (!pending)
+		{
+			busy = false;
+		}
+	}
+}
+
+void Renderer::RunJob(const Job &job)
+{
+	const auto &settings = job.settings;
+	const auto start = std::chrono::steady_clock::now();
+
+	// everything but anchor, origin and iteration limit: pixels of the same view can be moved and continued (or cut short)
+	auto view = settings;
+	view.anchor = {};
+	view.origin = {};
+	view.maxIterations = 0;
+	const auto viewFingerprint = Fingerprint(view);
+
+	// everything that decides if the previous image can be resampled as a preview
+	auto layout = view;
+	layout.zoom = 0.0;
+	layout.precision = Precision_Float64;
+	layout.kernels = nullptr;
+	layout.engine = RenderEngine_Direct;
+	layout.algorithm = RenderAlgorithm_BruteForce;
+	layout.periodicity = false;
+	const auto layoutFingerprint = Fingerprint(layout);
+
+	{
+		std::lock_guard lock(outputMutex);
+
+		if (buffer.width != settings.width || buffer.height != settings.height)
+		{
+			buffer.Resize(settings.width, settings.height);
+			presentedColors.reset();
+		}
+		buffer.maxIterations = settings.maxIterations;
+
+		// the previous view counted from the anchor of this one, a moved anchor moves the origin by whole pixels
+		auto placed = bufferAnchor == settings.anchor;
+		if (!placed)
+		{
+			Vec2l moved;
+			placed = bufferAnchor.PixelsFrom(settings.anchor, bufferZoom, moved);
+			bufferOrigin.x += moved.x;
+			bufferOrigin.y += moved.y;
+		}
+
+		if (placed && bufferView != viewFingerprint && bufferLayout == layoutFingerprint)
+		{
+			// zoomed (or switched precision), show the previous image resampled until the tiles come in
+			buffer.Reproject(bufferOrigin, bufferZoom, settings.origin, settings.zoom);
+			finishedTiles = { SDL_Rect { 0, 0, buffer.width, buffer.height } };
+		}
+		else if (!placed || bufferView != viewFingerprint)
+		{
+			std::fill(buffer.limits.begin(), buffer.limits.end(), 0);
+
+			// tiles of a previous view are outdated
+			finishedTiles.clear();
+		}
+		else if (bufferOrigin != settings.origin)
+		{
+			// panned, only the uncovered strips are left to compute
+			const auto dx = bufferOrigin.x - settings.origin.x;
+			const auto dy = bufferOrigin.y - settings.origin.y;
+			const auto shift = std::abs(dx) < buffer.width && std::abs(dy) < buffer.height
+				? Vec2 { (int)dx, (int)dy }
+				: Vec2 { buffer.width, buffer.height };
+
+			buffer.Shift(shift.x, shift.y);
+			presentShift.x += shift.x;
+			presentShift.y += shift.y;
+
+			// tiles waiting for Present moved along
+			for (auto &tile : finishedTiles)
+			{
+				const auto left = std::max(tile.x + shift.x, 0);
+				const auto top = std::max(tile.y + shift.y, 0);
+				const auto right = std::min(tile.x + tile.w + shift.x, buffer.width);
+				const auto bottom = std::min(tile.y + tile.h + shift.y, buffer.height);
+				tile = { left, top, std::max(right - left, 0), std::max(bottom - top, 0) };
+			}
+		}
+		bufferView = viewFingerprint;
+		bufferLayout = layoutFingerprint;
+		bufferAnchor = settings.anchor;
+		bufferOrigin = settings.origin;
+		bufferZoom = settings.zoom;
+	}
+
+	iterated = 0;
+	resumed = 0;
+	reused = 0;
+	cached = 0;
+	filled = 0;
+	glitched = 0;
+	references = 0;
+	corrected = 0;
+	skipped = 0;
+
+	std::shared_ptr<const Perturbation::Reference> jobReference;
+	Perturbation::Context perturbation = {};
+	Perturbation::BlaTable bla;
+
+	// the series and the approximations have to hold for the view corner farthest from the reference
+	const auto setUpPerturbation = [&](const Perturbation::Reference &reference)
+	{
+		const auto farX = std::max(reference.pixel.x - settings.origin.x, settings.origin.x + settings.width - reference.pixel.x);
+		const auto farY = std::max(reference.pixel.y - settings.origin.y, settings.origin.y + settings.height - reference.pixel.y);
+		const auto radius = std::hypot((double)farX, (double)farY) / settings.zoom;
+		perturbation = { &reference, Perturbation::ComputeSeries(reference, radius), nullptr };
+
+		if (settings.engine == RenderEngine_Bla)
+		{
+			bla = Perturbation::ComputeBlaTable(reference, radius);
+			perturbation.bla = &bla;
+		}
+	};
+
+	// the reference stays while it is in view, so panning doesn't recompute it
+	if (settings.engine != RenderEngine_Direct && settings.fractal == FractalId_Mandelbrot)
+	{
+		const auto inView = reference
+			&& reference->pixel.x >= settings.origin.x && reference->pixel.x < settings.origin.x + settings.width
+			&& reference->pixel.y >= settings.origin.y && reference->pixel.y < settings.origin.y + settings.height;
+
+		if (!inView || reference->anchor != settings.anchor || reference->zoom != settings.zoom || reference->maxIterations != settings.maxIterations)
+		{
+			const Vec2l center = { settings.origin.x + settings.width / 2, settings.origin.y + settings.height / 2 };
+			reference = Perturbation::ComputeReference(settings.anchor, center, settings.zoom, settings.maxIterations, [&] { return IsCancelled(job); });
+			if (!reference)
+			{
+				return;
+			}
+		}
+
+		jobReference = reference;
+		setUpPerturbation(*jobReference);
+		skipped = perturbation.series.skipped;
+		references = 1;
+	}
+
+	// tiles are aligned to the world pixel grid, so a tile covers the same pixels wherever the view is
+	const auto firstX = (int)(FloorDiv(settings.origin.x, TileSize) * TileSize - settings.origin.x);
+	const auto firstY = (int)(FloorDiv(settings.origin.y, TileSize) * TileSize - settings.origin.y);
+
+	std::vector<SDL_Rect> tiles;
+	for (int y = firstY; y < settings.height; y += TileSize)
+	{
+		for (int x = firstX; x < settings.width; x += TileSize)
+		{
+			const auto left = std::max(x, 0);
+			const auto top = std::max(y, 0);
+			tiles.push_back({
+				left,
+				top,
+				std::min(x + TileSize, settings.width) - left,
+				std::min(y + TileSize, settings.height) - top
+			});
+		}
+	}
+
+	// progressive: every 4th pixel of every 4th row first, then every 2nd, then the rest, each pass shown upscaled.
+	// Every pixel is still iterated once, later passes skip the samples of earlier ones.
+	const auto steps = settings.progressive ? std::vector<int> { 4, 2, 1 } : std::vector<int> { 1 };
+
+	const auto renderPass = [&](const int step, const bool firstPass, const Perturbation::Context *perturbation, const bool correction = false)
+	{
+		TaskGroup group;
+
+		// the cost of a tile varies wildly, the pool balances them by stealing
+		for (const auto &tile : tiles)
+		{
+			pool.Submit(group, [this, &job, &tile, step, firstPass, perturbation, correction] {
+				RenderTile(job, tile, perturbation, step, firstPass, correction);
+			});
+		}
+
+		pool.Wait(group);
+	};
+
+	for (const auto step : steps)
+	{
+		renderPass(step, step == steps.front(), jobReference ? &perturbation : nullptr);
+
+		if (IsCancelled(job))
+		{
+			return;
+		}
+	}
+
+	// glitch correction: a new reference in the largest blob of glitched pixels, then only the glitched pixels again.
+	// Finished tiles are skipped right away, so this costs little more than the glitched pixels themselves.
+	for (size_t round = 0; jobReference; ++round)
+	{
+		size_t count = 0;
+		const auto candidates = FindGlitch(buffer, count);
+		if (round == 0)
+		{
+			glitched = count;
+		}
+
+		if (candidates.empty())
+		{
+			break;
+		}
+
+		// out of references, iterate whatever is left directly
+		if (round == MaxGlitchReferences)
+		{
+			renderPass(1, false, nullptr, true);
+			break;
+		}
+
+		// pixels that outlived the reference need a longer orbit, so take the longest, or the first that doesn't escape at all
+		jobReference = nullptr;
+		for (const auto &candidate : candidates)
+		{
+			const Vec2l pixel = { settings.origin.x + candidate.x, settings.origin.y + candidate.y };
+			auto next = Perturbation::ComputeReference(settings.anchor, pixel, settings.zoom, settings.maxIterations, [&] { return IsCancelled(job); });
+			if (!next)
+			{
+				return;
+			}
+
+			if (!jobReference || next->real.size() > jobReference->real.size())
+			{
+				jobReference = std::move(next);
+			}
+
+			if (jobReference->real.size() > settings.maxIterations)
+			{
+				break;
+			}
+		}
+
+		setUpPerturbation(*jobReference);
+		references++;
+		renderPass(1, false, &perturbation, true);
+
+		if (IsCancelled(job))
+		{
+			return;
+		}
+	}
+
+	// every pixel of the view went through the passes before correction exactly once
+	reused = (size_t)settings.width * settings.height - iterated - resumed - cached - filled;
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Renderer::RenderTile(const Job &job, const SDL_Rect &tile, const Perturbation::Context *perturbation, const int step, const bool firstPass, const bool correction)
+{
+	const auto &settings = job.settings;
+	const auto iterate = settings.kernels->iterate[settings.fractal][settings.precision];
+	const auto maxIterations = settings.maxIterations;
+
+	// this task is the only writer of the tile, so reading it needs no lock
+	auto finished = true;
+	for (int y = tile.y; y < tile.y + tile.h && finished; ++y)
+	{
+		const auto row = &buffer.limits[y * buffer.width];
+		finished = std::all_of(row + tile.x, row + tile.x + tile.w, [&](const size_t limit) { return limit == maxIterations; });
+	}
+
+	if (finished)
+	{
+		return;
+	}
+
+	const TileKey key = {
+		settings.fractal,
+		settings.precision,
+		settings.engine,
+		settings.algorithm,
+		settings.periodicity,
+		maxIterations,
+		settings.zoom,
+		settings.anchor.Hash(),
+		FloorDiv(settings.origin.x + tile.x, TileSize),
+		FloorDiv(settings.origin.y + tile.y, TileSize)
+	};
+	const auto complete = tile.w == TileSize && tile.h == TileSize;
+
+	// later passes only get here if the tile was not cached
+	if (const auto data = firstPass ? cache.Find(key) : nullptr)
+	{
+		// at the edge of the view only part of the cached tile is visible
+		const auto offsetX = (int)(settings.origin.x + tile.x - key.x * TileSize);
+		const auto offsetY = (int)(settings.origin.y + tile.y - key.y * TileSize);
+
+		std::lock_guard lock(outputMutex);
+		if (IsCancelled(job))
+		{
+			return;
+		}
+
+		for (int y = 0; y < tile.h; ++y)
+		{
+			const auto index = (tile.y + y) * buffer.width + tile.x;
+			const auto from = (offsetY + y) * TileSize + offsetX;
+			std::copy_n(&data->iterations[from], tile.w, &buffer.iterations[index]);
+			std::copy_n(&data->smooth[from], tile.w, &buffer.smooth[index]);
+			std::copy_n(&data->zReal[from], tile.w, &buffer.zReal[index]);
+			std::copy_n(&data->zImag[from], tile.w, &buffer.zImag[index]);
+			std::fill_n(&buffer.limits[index], tile.w, maxIterations);
+		}
+		finishedTiles.push_back(tile);
+
+		cached += tile.w * tile.h;
+		return;
+	}
+
+	TileWork work(settings, tile, iterate, perturbation);
+	work.Load(buffer, correction);
+
+	const auto isCancelled = [&] { return IsCancelled(job); };
+
+	if (step > 1)
+	{
+		RenderSamples(work, step, isCancelled);
+
+		std::lock_guard lock(outputMutex);
+		if (IsCancelled(job))
+		{
+			return;
+		}
+
+		work.StorePreview(buffer, step);
+		finishedTiles.push_back(tile);
+
+		iterated += work.iterated;
+		resumed += work.resumed;
+		return;
+	}
+
+	[[maybe_unused]] const auto pending = work.CountPending();
+
+	switch (settings.algorithm)
+	{
+		case RenderAlgorithm_MarianiSilver:
+			RenderMarianiSilver(work, isCancelled);
+			break;
+
+		case RenderAlgorithm_BoundaryTracing:
+			RenderBoundaryTracing(work, isCancelled);
+			break;
+
+		default:
+			RenderBruteForce(work, isCancelled);
+			break;
+	}
+
+	if (IsCancelled(job))
+	{
+		return;
+	}
+
+	// every pixel without a result went through the kernel or got filled, exactly once
+	assert(work.iterated + work.resumed + work.filled == pending);
+
+	// only whole tiles go into the cache, the edges of the view are partial, glitched ones once they are corrected
+	if (complete && work.CanIterate() && !work.HasGlitches())
+	{
+		cache.Insert(key, std::make_shared<const TileData>(TileData {
+			{ work.iterations.begin(), work.iterations.end() },
+			{ work.smooth.begin(), work.smooth.end() },
+			{ work.zReal.begin(), work.zReal.end() },
+			{ work.zImag.begin(), work.zImag.end() }
+		}));
+	}
+
+	std::lock_guard lock(outputMutex);
+	if (IsCancelled(job))
+	{
+		return;
+	}
+
+	work.Store(buffer);
+	finishedTiles.push_back(tile);
+
+	if (correction)
+	{
+		corrected += work.iterated + work.resumed + work.filled;
+		return;
+	}
+
+	iterated += work.iterated;
+	resumed += work.resumed;
+	filled += work.filled;
+}
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Anchor.hpp"
+#include "Canvas.hpp"
+#include "Coloring.hpp"
+#include "Kernels.hpp"
+#include "Perturbation.hpp"
+#include "RenderAlgorithm.hpp"
+#include "ThreadPool.hpp"
+#include "TileCache.hpp"
+#include "Vec2.hpp"
+
+namespace Zen
+{
+
+/**
+ * @brief Everything that determines the rendered image.
+ */
+struct RenderSettings
+{
+	FractalId fractal;
+	Precision precision;
+	size_t maxIterations;
+	const Kernels::Table *kernels;
+	RenderEngine engine;
+	RenderAlgorithm algorithm;
+	bool progressive; // show passes with 1/16 and 1/4 of the pixels first
+	bool periodicity; // detect orbits caught in a cycle, within PeriodicityTolerance
+
+	Anchor anchor; // the point pixels are counted from
+	Vec2l origin;  // top left pixel, counted in pixels from the anchor, pixel p is at anchor + (origin + p) / zoom
+	double zoom;   // pixels per world unit
+	int width, height;
+};
+
+/**
+ * @brief Hash of everything that affects the iterations, equal fingerprints mean an equal image.
+ */
+auto Fingerprint(const RenderSettings &settings) -> size_t;
+
+/**
+ * @brief Per pixel output of the iteration stage. Coloring only reads this,
+ * so changing colors never requires iterating again.
+ */
+struct IterationBuffer
+{
+	int width = 0, height = 0;
+	size_t maxIterations = 0;
+
+	std::vector<size_t> iterations; // escape iteration
+	std::vector<float> smooth;      // fractional escape iteration
+	std::vector<double> zReal;      // z after the last iteration, lets pixels that hit the limit continue later
+	std::vector<double> zImag;
+	std::vector<size_t> limits;     // iteration limit the pixel was computed with, 0 if it holds no result, Perturbation::Glitched if glitched
+
+	void Resize(const int width, const int height);
+
+	/**
+	 * @brief Move every pixel by (dx, dy), uncovered pixels are marked as not computed
+	 */
+	void Shift(const int dx, const int dy);
+
+	/**
+	 * @brief Resample the contents from the view at (fromOrigin, fromZoom) into the view at (toOrigin, toZoom),
+	 * nearest neighbour. Meant as a preview, every pixel is marked as not computed.
+	 */
+	void Reproject(const Vec2l &fromOrigin, const double fromZoom, const Vec2l &toOrigin, const double toZoom);
+};
+
+/**
+ * @brief Counters of the last job
+ */
+struct RenderStats
+{
+	size_t iterated; // pixels iterated from scratch
+	size_t resumed;  // pixels continued from an earlier, lower iteration limit
+	size_t reused;   // pixels taken from the previous render without iterating
+	size_t cached;   // pixels taken from the tile cache
+	size_t filled;   // pixels given the count of their surroundings without iterating
+	size_t glitched;   // perturbation: pixels the first reference could not be used for
+	size_t references; // perturbation: references it took to correct them
+	size_t corrected;  // perturbation: pixels redone while correcting, not part of the counts above
+	size_t skipped;    // perturbation: iterations of every pixel skipped by the series
+	double seconds;  // how long the last finished render took
+};
+
+/**
+ * @brief Renders in the background, splitting the image into tiles that are iterated on a thread pool.
+ * Requesting different settings cancels the job in flight, finished tiles are colored into the canvas
+ * by Present, so the calling (UI) thread never waits for a render.
+ * Tiles are aligned to the world pixel grid, complete ones are kept in the tile cache.
+ */
+class Renderer
+{
+public:
+	static constexpr int TileSize = 64;
+	static constexpr double PeriodicityTolerance = 1.0 / 64.0; // in pixels
+	static constexpr size_t MaxGlitchReferences = 16; // per render, on top of the first one
+
+public:
+	Renderer(ThreadPool &pool, TileCache &cache);
+	~Renderer();
+
+	Renderer(const Renderer &) = delete;
+	Renderer &operator=(const Renderer &) = delete;
+
+public:
+	/**
+	 * @brief Start rendering settings, unless their fingerprint matches the last request,
+	 * in which case the previous result is kept.
+	 */
+	void Request(const RenderSettings &settings);
+
+	/**
+	 * @brief Color the tiles finished since the last call into canvas.
+	 * If colors changed since the last call the whole canvas is recolored, without iterating again.
+	 * If the view was panned, the canvas is shifted along with the iterations.
+	 */
+	void Present(Canvas &canvas, const ColorSettings &colors);
+
+	/**
+	 * @brief Check if a job is still running
+	 */
+	auto IsBusy() const -> bool { return busy; }
+
+	/**
+	 * @brief Check if neither a job is running nor finished tiles wait for Present
+	 */
+	auto IsIdle() -> bool;
+
+	auto GetStats() const -> RenderStats { return { iterated, resumed, reused, cached, filled, glitched, references, corrected, skipped, seconds }; }
+
+private:
+	struct Job
+	{
+		RenderSettings settings;
+		size_t generation;
+	};
+
+private:
+	void ThreadLoop();
+	void RunJob(const Job &job);
+	/**
+	 * @brief Render a tile, or only its samples step pixels apart, shown upscaled, if step is above 1.
+	 * With perturbation, pixels are iterated as deltas from its reference.
+	 * Pixels of a correction pass count as corrected only.
+	 */
+	void RenderTile(const Job &job, const SDL_Rect &tile, const Perturbation::Context *perturbation, const int step, const bool firstPass, const bool correction);
+
+	auto IsCancelled(const Job &job) const -> bool { return generation != job.generation; }
+
+private:
+	ThreadPool &pool;
+	TileCache &cache;
+
+	// requests, written by the caller and consumed by the render thread
+	std::optional<size_t> requestedFingerprint;
+	std::optional<Job> pending;
+	std::atomic<size_t> generation = 0;
+	std::atomic<bool> busy = false;
+	bool stopping = false;
+	std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+
+	// output of the current job, guarded by outputMutex
+	std::mutex outputMutex;
+	IterationBuffer buffer;
+	std::vector<SDL_Rect> finishedTiles;
+	std::optional<size_t> presentedColors;
+	Vec2 presentShift; // pan the canvas has not caught up with yet
+
+	// the view buffer belongs to, ignoring anchor, origin and iteration limit
+	std::optional<size_t> bufferView;
+	// the view ignoring everything that can be reprojected (origin, zoom, precision...)
+	std::optional<size_t> bufferLayout;
+	Anchor bufferAnchor;
+	Vec2l bufferOrigin;
+	double bufferZoom = 0.0;
+
+	// perturbation reference of the current job, only replaced by the render thread between jobs
+	std::shared_ptr<const Perturbation::Reference> reference;
+
+	std::atomic<size_t> iterated = 0;
+	std::atomic<size_t> resumed = 0;
+	std::atomic<size_t> reused = 0;
+	std::atomic<size_t> cached = 0;
+	std::atomic<size_t> filled = 0;
+	std::atomic<size_t> glitched = 0;
+	std::atomic<size_t> references = 0;
+	std::atomic<size_t> corrected = 0;
+	std::atomic<size_t> skipped = 0;
+	std::atomic<double> seconds = 0.0;
+
+	// started last, everything above is initialized by then
+	std::thread thread;
+};
+
+}
@@ -0,0 +1,144 @@
+#include "ThreadPool.hpp"
+
+namespace Zen
+{
+
+// Pool and queue owned by the current thread, currentPool is nullptr outside of any pool
+static thread_local ThreadPool *currentPool = nullptr;
+static thread_local size_t currentQueue = 0;
+
+ThreadPool::ThreadPool(const size_t threadCount)
+{
+	const auto count = threadCount > 0 ? threadCount : 1;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Submit(TaskGroup &group, Task task)
+{
+	const auto index = currentPool == this ? currentQueue : nextQueue++ % queues.size();
+
+	group.remaining++;
+	{
+		std::lock_guard lock(queues[index]->mutex);
+		queues[index]->tasks.emplace_back(&group, std::move(task));
+	}
+
+	{
+		std::lock_guard lock(sleepMutex);
+		queued++;
+	}
+	wakeUp.notify_one();
+}
+
+void ThreadPool::Wait(TaskGroup &group)
+{
+	const auto self = currentPool == this ? currentQueue : 0;
+
+	while (group.remaining > 0)
+	{
+		if (RunOne(self))
+		{
+			continue;
+		}
+
+		// the last tasks are running on other workers, sleep until they finish the group or new tasks come in
+		std::unique_lock lock(sleepMutex);
+		wakeUp.wait(lock, [&] { return group.remaining == 0 || queued > 0; });
+	}
+}
+
+void ThreadPool::WorkerLoop(const size_t self)
+{
+	currentPool = this;
+	currentQueue = self;
+
+	while (true)
+	{
+		if (RunOne(self))
+		{
+			continue;
+		}
+
+		std::unique_lock lock(sleepMutex);
+		wakeUp.wait(lock, [&] { return stopping || queued > 0; });
+
+		if (stopping)
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::RunOne(const size_t self)
+{
+	TaskGroup *group = nullptr;
+	Task task;
+
+	for (size_t i = 0; i < queues.size() && !task; ++i)
+	{
+		const auto index = (self + i) % queues.size();
+		auto &queue = *queues[index];
+
+		std::lock_guard lock(queue.mutex);
+		if (queue.tasks.empty())
+		{
+			continue;
+		}
+
+		// own tasks LIFO (still hot in cache), stolen tasks FIFO (the oldest, usually biggest, work)
+		auto &entry = i == 0 ? queue.tasks.back() : queue.tasks.front();
+		group = entry.first;
+		task = std::move(entry.second);
+
+		if (i == 0)
+		{
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			queue.tasks.pop_front();
+		}
+	}
+
+	if (!task)
+	{
+		return false;
+	}
+
+	queued--;
+	task();
+
+	if (--group->remaining == 0)
+	{
+		// under the lock, so a Wait between checking the group and going to sleep can't miss it
+		std::lock_guard lock(sleepMutex);
+		wakeUp.notify_all();
+	}
+
+	return true;
+}
+
+}
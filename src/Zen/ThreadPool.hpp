@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Zen
+{
+
+/**
+ * @brief Counts the unfinished tasks submitted with it, so they can be waited on as a whole.
+ */
+struct TaskGroup
+{
+	std::atomic<size_t> remaining = 0;
+};
+
+/**
+ * @brief Work stealing thread pool.
+ * Every worker owns a deque: it pops its own tasks from the back and steals from the front
+ * of the others once it runs dry, so uneven tasks (like fractal tiles) still balance out.
+ */
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+public:
+	/**
+	 * @brief Start threadCount workers, defaults to one per hardware thread
+	 */
+	explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+public:
+	/**
+	 * @brief Queue a task. Tasks submitted from a worker go to that worker's own deque.
+	 */
+	void Submit(TaskGroup &group, Task task);
+
+	/**
+	 * @brief Block until every task of group finished. The calling thread runs queued tasks meanwhile,
+	 * and sleeps once the last ones run on other workers.
+	 */
+	void Wait(TaskGroup &group);
+
+	auto ThreadCount() const -> size_t { return threads.size(); }
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::pair<TaskGroup *, Task>> tasks;
+	};
+
+private:
+	void WorkerLoop(const size_t self);
+
+	/**
+	 * @brief Run one task, preferring the queue at index self, stealing from the others otherwise.
+	 * @return false if every queue was empty
+	 */
+	bool RunOne(const size_t self);
+
+private:
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> nextQueue = 0;
+
+	std::atomic<size_t> queued = 0;
+	std::atomic<bool> stopping = false;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+};
+
+}
@@ -0,0 +1,127 @@
+#include "TileCache.hpp"
+
+#include "Hash.hpp"
+#include "TileStore.hpp"
+
+namespace Zen
+{
+
+auto Fingerprint(const TileKey &key) -> size_t
+{
+	auto hash = HashSeed;
+	hash = HashValue(hash, key.fractal);
+	hash = HashValue(hash, key.precision);
+	hash = HashValue(hash, key.engine);
+	hash = HashValue(hash, key.algorithm);
+	hash = HashValue(hash, key.periodicity);
+	hash = HashValue(hash, key.maxIterations);
+	hash = HashValue(hash, key.zoom);
+	hash = HashValue(hash, key.anchor);
+	hash = HashValue(hash, key.x);
+	hash = HashValue(hash, key.y);
+	return hash;
+}
+
+auto TileData::Bytes() const -> size_t
+{
+	return sizeof(TileData)
+		+ iterations.size() * sizeof(size_t)
+		+ smooth.size() * sizeof(float)
+		+ zReal.size() * sizeof(double)
+		+ zImag.size() * sizeof(double);
+}
+
+TileCache::TileCache(const size_t budget, TileStore *store)
+	: store(store)
+	, budget(budget)
+{
+}
+
+auto TileCache::Find(const TileKey &key) -> std::shared_ptr<const TileData>
+{
+	{
+		std::lock_guard lock(mutex);
+
+		const auto it = index.find(key);
+		if (it != index.end())
+		{
+			hits++;
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->tile;
+		}
+
+		misses++;
+	}
+
+	// outside the lock, other threads keep using the memory cache meanwhile
+	auto tile = std::make_shared<TileData>();
+	if (!store || !store->Read(key, *tile))
+	{
+		return nullptr;
+	}
+
+	Put(key, tile);
+	return tile;
+}
+
+void TileCache::Insert(const TileKey &key, std::shared_ptr<const TileData> tile)
+{
+	if (store)
+	{
+		store->Write(key, *tile);
+	}
+
+	Put(key, std::move(tile));
+}
+
+void TileCache::Put(const TileKey &key, std::shared_ptr<const TileData> tile)
+{
+	std::lock_guard lock(mutex);
+
+	if (const auto it = index.find(key); it != index.end())
+	{
+		bytes -= it->second->tile->Bytes();
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	bytes += tile->Bytes();
+	entries.push_front({ key, std::move(tile) });
+	index[key] = entries.begin();
+
+	Evict();
+}
+
+void TileCache::SetBudget(const size_t budget)
+{
+	std::lock_guard lock(mutex);
+	this->budget = budget;
+	Evict();
+}
+
+void TileCache::Clear()
+{
+	std::lock_guard lock(mutex);
+	entries.clear();
+	index.clear();
+	bytes = 0;
+}
+
+auto TileCache::GetStats() const -> TileCacheStats
+{
+	std::lock_guard lock(mutex);
+	return { hits, misses, entries.size(), bytes, budget };
+}
+
+void TileCache::Evict()
+{
+	while (bytes > budget && !entries.empty())
+	{
+		const auto &last = entries.back();
+		bytes -= last.tile->Bytes();
+		index.erase(last.key);
+		entries.pop_back();
+	}
+}
+
+}
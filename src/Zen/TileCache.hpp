@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Fractals.hpp"
+#include "Precision.hpp"
+#include "RenderAlgorithm.hpp"
+
+namespace Zen
+{
+
+/**
+ * @brief Identifies a tile of the pyramid: the zoom level and the tile position on that level,
+ * plus everything else that changes its iterations. The instruction set is left out,
+ * every kernel produces the exact same iterations.
+ */
+struct TileKey
+{
+	FractalId fractal;
+	Precision precision;
+	RenderEngine engine;
+	RenderAlgorithm algorithm; // filling algorithms can differ from iterating every pixel
+	bool periodicity;          // so can cycle detection
+	size_t maxIterations;
+	double zoom; // zoom only takes discrete steps, so this is the zoom level
+	size_t anchor; // hash of the point the tiles are counted from, see Anchor
+	int64_t x, y; // in tiles from the anchor
+
+	auto operator==(const TileKey &) const -> bool = default;
+};
+
+auto Fingerprint(const TileKey &key) -> size_t;
+
+/**
+ * @brief Iteration results of a whole tile, row by row
+ */
+struct TileData
+{
+	std::vector<size_t> iterations;
+	std::vector<float> smooth;
+	std::vector<double> zReal;
+	std::vector<double> zImag;
+
+	auto Bytes() const -> size_t;
+};
+
+class TileStore;
+
+struct TileCacheStats
+{
+	size_t hits, misses;
+	size_t tiles, bytes, budget;
+};
+
+/**
+ * @brief Keeps rendered tiles around, so panning back or zooming back out does not iterate again.
+ * Once the tiles exceed the byte budget, the least recently used ones are evicted.
+ * With a store, tiles are also written to disk, and tiles missing in memory are looked up there.
+ * Safe to use from multiple threads.
+ */
+class TileCache
+{
+public:
+	explicit TileCache(const size_t budget, TileStore *store = nullptr);
+
+	TileCache(const TileCache &) = delete;
+	TileCache &operator=(const TileCache &) = delete;
+
+public:
+	/**
+	 * @brief Look up a tile and mark it as used, a tile found in the store is kept in memory from then on
+	 * @return The tile, nullptr if it is not cached
+	 */
+	auto Find(const TileKey &key) -> std::shared_ptr<const TileData>;
+
+	/**
+	 * @brief Add a tile (or replace the one with the same key), evicting others if the budget is exceeded
+	 */
+	void Insert(const TileKey &key, std::shared_ptr<const TileData> tile);
+
+	void SetBudget(const size_t budget);
+	void Clear();
+
+	auto GetStats() const -> TileCacheStats;
+
+private:
+	struct Entry
+	{
+		TileKey key;
+		std::shared_ptr<const TileData> tile;
+	};
+
+	struct KeyHash
+	{
+		auto operator()(const TileKey &key) const -> size_t { return Fingerprint(key); }
+	};
+
+private:
+	/**
+	 * @brief Insert without writing to the store
+	 */
+	void Put(const TileKey &key, std::shared_ptr<const TileData> tile);
+
+	/**
+	 * @brief Drop least recently used tiles until the budget fits, mutex has to be held
+	 */
+	void Evict();
+
+private:
+	TileStore *store;
+
+	mutable std::mutex mutex;
+	std::list<Entry> entries; // most recently used first
+	std::unordered_map<TileKey, std::list<Entry>::iterator, KeyHash> index;
+
+	size_t budget;
+	size_t bytes = 0;
+	size_t hits = 0, misses = 0;
+};
+
+}
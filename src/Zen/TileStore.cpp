@@ -0,0 +1,285 @@
+#include "TileStore.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Zen
+{
+
+static constexpr char Magic[8] = { 'Z', 'E', 'N', 'T', 'I', 'L', 'E', 'S' };
+static constexpr uint32_t Version = 5;
+static constexpr size_t PageSize = 4096;
+static constexpr size_t HeaderSize = PageSize;
+static constexpr size_t SlotHeaderSize = 128;
+
+static_assert(sizeof(size_t) == sizeof(uint64_t), "iterations are stored as 64 bit");
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t tilePixels;
+	uint64_t slotCount;
+};
+
+struct SlotHeader
+{
+	uint64_t checksum; // of key and tile, 0 if the slot is empty or being written
+	TileKey key;
+};
+
+static_assert(sizeof(SlotHeader) <= SlotHeaderSize);
+
+static auto RoundUp(const size_t value, const size_t multiple) -> size_t
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * @brief Where the arrays of a tile start within a slot
+ */
+struct SlotLayout
+{
+	size_t iterations, smooth, zReal, zImag, end;
+
+	explicit SlotLayout(const size_t pixels)
+	{
+		iterations = SlotHeaderSize;
+		smooth = iterations + pixels * sizeof(size_t);
+		zReal = RoundUp(smooth + pixels * sizeof(float), sizeof(double));
+		zImag = zReal + pixels * sizeof(double);
+		end = zImag + pixels * sizeof(double);
+	}
+};
+
+TileStore::TileStore(const std::string &path, const size_t bytes, const size_t tilePixels)
+	: path(path)
+	, tilePixels(tilePixels)
+{
+	Open(bytes);
+}
+
+TileStore::~TileStore()
+{
+	if (mapping)
+	{
+		munmap(mapping, mappingSize);
+	}
+
+	if (file >= 0)
+	{
+		close(file);
+	}
+}
+
+void TileStore::Open(const size_t bytes)
+{
+	if (path.empty())
+	{
+		return;
+	}
+
+	slotSize = RoundUp(SlotLayout(tilePixels).end, PageSize);
+	slotCount = bytes > HeaderSize ? (bytes - HeaderSize) / slotSize : 0;
+	mappingSize = HeaderSize + slotCount * slotSize;
+	if (slotCount == 0)
+	{
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+	file = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (file < 0)
+	{
+		return;
+	}
+
+	// one process per file, the slots are not synchronized between processes
+	struct stat status;
+	if (flock(file, LOCK_EX | LOCK_NB) != 0 || fstat(file, &status) != 0)
+	{
+		close(file);
+		file = -1;
+		return;
+	}
+
+	auto fresh = (size_t)status.st_size != mappingSize;
+	if (!fresh)
+	{
+		FileHeader header;
+		fresh = pread(file, &header, sizeof(header), 0) != sizeof(header)
+			|| std::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+			|| header.version != Version
+			|| header.tilePixels != tilePixels
+			|| header.slotCount != slotCount;
+	}
+
+	// truncating zeroes the file, and a zero checksum marks a slot as empty
+	if (fresh && (ftruncate(file, 0) != 0 || ftruncate(file, mappingSize) != 0))
+	{
+		close(file);
+		file = -1;
+		return;
+	}
+
+	const auto memory = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (memory == MAP_FAILED)
+	{
+		close(file);
+		file = -1;
+		return;
+	}
+	mapping = (uint8_t *)memory;
+
+	// the header goes in last, a file that was cut short while being created gets recreated
+	if (fresh)
+	{
+		FileHeader header = {};
+		std::memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = Version;
+		header.tilePixels = tilePixels;
+		header.slotCount = slotCount;
+		std::memcpy(mapping, &header, sizeof(header));
+	}
+
+	verified.assign(slotCount, false);
+}
+
+auto TileStore::GetSlot(const TileKey &key) -> uint8_t *
+{
+	return mapping + HeaderSize + Fingerprint(key) % slotCount * slotSize;
+}
+
+auto TileStore::Checksum(const uint8_t *slot) const -> uint64_t
+{
+	// FNV-1a over 64 bit words instead of bytes, tiles are large and this runs on every first read
+	const auto begin = offsetof(SlotHeader, key);
+	const auto end = RoundUp(SlotLayout(tilePixels).end, sizeof(uint64_t));
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (auto offset = begin; offset < end; offset += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, slot + offset, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+
+	// 0 means empty
+	return hash | 1;
+}
+
+auto TileStore::Read(const TileKey &key, TileData &tile) -> bool
+{
+	if (!mapping)
+	{
+		return false;
+	}
+
+	std::lock_guard lock(mutex);
+
+	const auto slot = GetSlot(key);
+	const auto index = (slot - mapping - HeaderSize) / slotSize;
+	auto &header = *(SlotHeader *)slot;
+
+	if (header.checksum == 0 || !(header.key == key))
+	{
+		misses++;
+		return false;
+	}
+
+	if (!verified[index])
+	{
+		if (Checksum(slot) != header.checksum)
+		{
+			// torn by a crash
+			header.checksum = 0;
+			misses++;
+			return false;
+		}
+		verified[index] = true;
+	}
+
+	const SlotLayout layout(tilePixels);
+	tile.iterations.assign((const size_t *)(slot + layout.iterations), (const size_t *)(slot + layout.smooth));
+	tile.smooth.assign((const float *)(slot + layout.smooth), (const float *)(slot + layout.smooth) + tilePixels);
+	tile.zReal.assign((const double *)(slot + layout.zReal), (const double *)(slot + layout.zImag));
+	tile.zImag.assign((const double *)(slot + layout.zImag), (const double *)(slot + layout.end));
+
+	hits++;
+	return true;
+}
+
+void TileStore::Write(const TileKey &key, const TileData &tile)
+{
+	if (!mapping
+		|| tile.iterations.size() != tilePixels
+		|| tile.smooth.size() != tilePixels
+		|| tile.zReal.size() != tilePixels
+		|| tile.zImag.size() != tilePixels)
+	{
+		return;
+	}
+
+	std::lock_guard lock(mutex);
+
+	const auto slot = GetSlot(key);
+	const auto index = (slot - mapping - HeaderSize) / slotSize;
+	auto &header = *(SlotHeader *)slot;
+
+	// invalidate first, a crash while writing leaves an empty slot rather than a mixed one
+	header.checksum = 0;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+
+	const SlotLayout layout(tilePixels);
+	header.key = key;
+	std::memcpy(slot + layout.iterations, tile.iterations.data(), tilePixels * sizeof(size_t));
+	std::memcpy(slot + layout.smooth, tile.smooth.data(), tilePixels * sizeof(float));
+	std::memcpy(slot + layout.zReal, tile.zReal.data(), tilePixels * sizeof(double));
+	std::memcpy(slot + layout.zImag, tile.zImag.data(), tilePixels * sizeof(double));
+
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	header.checksum = Checksum(slot);
+
+	verified[index] = true;
+	writes++;
+}
+
+auto TileStore::GetStats() const -> TileStoreStats
+{
+	std::lock_guard lock(mutex);
+	return { hits, misses, writes, slotCount };
+}
+
+auto TileStore::DefaultPath() -> std::string
+{
+	if (const char *path = std::getenv("ZEN_TILE_STORE"))
+	{
+		return path;
+	}
+
+	if (const char *cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+	{
+		return std::string(cache) + "/zen/tiles";
+	}
+
+	if (const char *home = std::getenv("HOME"))
+	{
+		return std::string(home) + "/.cache/zen/tiles";
+	}
+
+	return "";
+}
+
+}
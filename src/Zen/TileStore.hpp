@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "TileCache.hpp"
+
+namespace Zen
+{
+
+struct TileStoreStats
+{
+	size_t hits, misses, writes;
+	size_t slots;
+};
+
+/**
+ * @brief Tiles kept on disk across runs, in a single memory mapped file of fixed size.
+ * The file is split into slots, a tile goes into the slot its key hashes to and replaces whatever was there,
+ * which bounds the size. Every slot carries a checksum written after the tile, a slot torn by a crash
+ * fails the check and reads as empty. If the file can't be opened (or another instance holds it),
+ * the store stays closed and every read misses.
+ */
+class TileStore
+{
+public:
+	/**
+	 * @param path The file, created if it doesn't exist and recreated if its layout doesn't match
+	 * @param bytes The size of the file
+	 * @param tilePixels Pixels per tile, every tile written has to have exactly this many
+	 */
+	TileStore(const std::string &path, const size_t bytes, const size_t tilePixels);
+	~TileStore();
+
+	TileStore(const TileStore &) = delete;
+	TileStore &operator=(const TileStore &) = delete;
+
+public:
+	auto IsOpen() const -> bool { return mapping != nullptr; }
+	auto GetPath() const -> const std::string & { return path; }
+
+	/**
+	 * @brief Copy a tile out of the store
+	 * @return false if the tile is not stored
+	 */
+	auto Read(const TileKey &key, TileData &tile) -> bool;
+
+	void Write(const TileKey &key, const TileData &tile);
+
+	auto GetStats() const -> TileStoreStats;
+
+	/**
+	 * @brief $ZEN_TILE_STORE, or a file in the user's cache directory, empty if there is none
+	 */
+	static auto DefaultPath() -> std::string;
+
+private:
+	void Open(const size_t bytes);
+	auto GetSlot(const TileKey &key) -> uint8_t *;
+	auto Checksum(const uint8_t *slot) const -> uint64_t;
+
+private:
+	std::string path;
+	size_t tilePixels;
+
+	int file = -1;
+	uint8_t *mapping = nullptr;
+	size_t mappingSize = 0;
+	size_t slotSize = 0;
+	size_t slotCount = 0;
+
+	mutable std::mutex mutex;
+	std::vector<bool> verified; // slots whose checksum was checked (or written) by this process
+	size_t hits = 0, misses = 0, writes = 0;
+};
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Zen
+{
+
+template<typename T>
+struct BasicVec2
+{
+	using Value_t = T;
+
+	T x = 0, y = 0;
+
+	bool operator==(const BasicVec2 &) const = default;
+};
+
+using Vec2 = BasicVec2<int>;
+using Vec2f = BasicVec2<double>;
+using Vec2l = BasicVec2<int64_t>;
+
+}